@@ -0,0 +1,163 @@
+// drives the plugin through scenarios against the stand-in host and checks
+// what it shows, failing if any does not behave
+
+#include <cstdio>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "host/host.hpp"
+#include "plugin.hpp"
+
+// an aerodrome with a runway along the parallel of its reference point, and
+// two stands of any size, lettered for code A and code E aircraft
+const char *const CONFIG =
+	"A EGKK\n"
+	"S 1 A\n"
+	"S 2 E\n"
+	"L 1 N051.09.10.000 W000.11.00.000\n"
+	"L 2 N051.09.10.000 W000.11.10.000\n"
+	"T A N051.09.00.000 W000.11.10.000 N051.09.00.000 W000.12.00.000\n";
+
+static std::string config_file;
+
+// a fresh world with the aerodrome and its runway active, and a plugin
+// loaded into it
+static Plugin *start() {
+	auto &w = host::world();
+	w.clear();
+	w.config = config_file;
+
+	host::Element ad;
+	ad.type = EuroScope::SECTOR_ELEMENT_AIRPORT;
+	ad.name = "EGKK";
+	ad.position[0].LoadFromStrings("W000.11.00.000", "N051.08.30.000");
+	ad.active[0][0] = ad.active[0][1] = true;
+	w.elements.push_back(ad);
+
+	host::Element rwy;
+	rwy.type = EuroScope::SECTOR_ELEMENT_RUNWAY;
+	rwy.name = "08R - 26L";
+	rwy.airport = "EGKK";
+	rwy.runway[0] = "08R";
+	rwy.runway[1] = "26L";
+	rwy.position[0].LoadFromStrings("W000.12.30.000", "N051.08.30.000");
+	rwy.position[1].LoadFromStrings("W000.10.00.000", "N051.08.30.000");
+	rwy.active[0][0] = rwy.active[0][1] = rwy.active[1][0] = rwy.active[1][1] = true;
+	w.elements.push_back(rwy);
+
+	w.controller = ad.position[0];
+	w.range = 1000;
+
+	return new Plugin();
+}
+
+static void move(Plugin *plugin, host::Aircraft &ac, const char *lon, const char *lat, int gs) {
+	ac.position.LoadFromStrings(lon, lat);
+	ac.gs = gs;
+	ac.track = 90;
+	plugin->OnRadarTargetPositionUpdate(host::radar_target(ac));
+}
+
+static bool runway_messages(const char *when, size_t expected) {
+	auto &w = host::world();
+
+	size_t count = 0;
+	for (const auto &msg : w.messages) count += msg.sender == "Runway";
+
+	if (count == expected) return true;
+
+	std::printf("  %s: %zu runway messages, expected %zu\n", when, count, expected);
+	for (const auto &msg : w.messages) std::printf("    %s: %s\n", msg.sender.c_str(), msg.text.c_str());
+	return false;
+}
+
+// a radar target with no flight plan is never disconnected; once it stops
+// being updated it must not be left on the runway it was last seen on
+static bool target_timeout() {
+	auto &w = host::world();
+	auto *plugin = start();
+	bool ok = true;
+
+	auto &target = w.add("NOFPL");
+	target.flight_plan = false;
+	move(plugin, target, "W000.11.00.000", "N051.08.30.000", 0);
+
+	// lining up, then starting the takeoff roll
+	auto &ac = w.add("BAW1");
+	move(plugin, ac, "W000.12.00.000", "N051.08.30.000", 10);
+	move(plugin, ac, "W000.11.50.000", "N051.08.30.000", 60);
+	ok &= runway_messages("rolling with the target there", 1);
+
+	move(plugin, ac, "W000.12.00.000", "N051.09.00.000", 10);
+	w.remove("NOFPL");
+	w.messages.clear();
+
+	for (int i = 0; i < 2 * TARGET_TIMEOUT; i++) plugin->OnTimer(i);
+
+	move(plugin, ac, "W000.12.00.000", "N051.08.30.000", 10);
+	move(plugin, ac, "W000.11.50.000", "N051.08.30.000", 60);
+	ok &= runway_messages("rolling after the target timed out", 0);
+
+	delete plugin;
+	w.clear();
+
+	return ok;
+}
+
+// stands are offered only to aircraft their letter takes, whether or not
+// the aircraft has one assigned already
+static bool stand_letter() {
+	auto &w = host::world();
+	auto *plugin = start();
+	bool ok = true;
+
+	auto offered = [&](const char *callsign, char wtc, const char *expected) {
+		auto &ac = w.add(callsign);
+		ac.origin = "EGKK";
+		ac.wtc = wtc;
+		move(plugin, ac, "W000.11.00.000", "N051.09.05.000", 0);
+
+		w.asel = callsign;
+		plugin->OnFunctionCall(TAG_FUNC_STAND_ALLOCATE, "", {}, {});
+
+		std::string stands;
+		for (const auto &el : w.popup) stands += (stands.empty() ? "" : " ") + el.first;
+		if (stands == expected) return true;
+
+		std::printf("  %c offered \"%s\", expected \"%s\"\n", wtc, stands.c_str(), expected);
+		return false;
+	};
+
+	ok &= offered("BAW1", 'H', "2");
+	ok &= offered("GABC", 'L', "1 2");
+
+	delete plugin;
+	w.clear();
+
+	return ok;
+}
+
+int main() {
+	config_file = (std::filesystem::temp_directory_path() / "vsmrplus-checks.txt").string();
+	std::ofstream(config_file) << CONFIG;
+
+	const std::pair<const char *, std::function<bool()>> checks[] = {
+		{ "target_timeout", target_timeout },
+		{ "stand_letter", stand_letter },
+	};
+
+	int failed = 0;
+	for (const auto &[name, check] : checks) {
+		bool ok = check();
+		std::printf("%-24s %s\n", name, ok ? "ok" : "FAILED");
+		failed += !ok;
+	}
+
+	std::filesystem::remove(config_file);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+// checks the error of each aerodrome's local frame against the great circle
+// distances EuroScope gives, out to the edge of the frame, and fails if any
+// exceeds the tolerance the surface checks are written for
+
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <numbers>
+#include <random>
+
+#include "plugin.hpp"
+
+const int SAMPLES = 20000;
+const float PAIR_SPAN = 3000; // m, the most surface geometry spans
+
+// the orthographic projection shortens distances from the origin by about
+// r³/6R², a quarter of a metre at 40 km; across a span of surface geometry
+// it is a few centimetres, with float rounding at the edge of the frame
+const double ORIGIN_TOLERANCE = 0.5; // m at FRAME_RANGE
+const double PAIR_TOLERANCE = 0.1; // m at FRAME_RANGE
+const double ROUND_TRIP_TOLERANCE = 0.05; // m
+
+struct Origin {
+	const char *name;
+	double lat, lon;
+};
+
+// the equator, mid latitudes both sides, the far north, and a frame across
+// the antimeridian
+const Origin ORIGINS[] = {
+	{ "equator", 0, 30 },
+	{ "EGKK", 51.148, -0.190 },
+	{ "NZAA", -37.008, 174.792 },
+	{ "ENSB", 78.246, 15.466 },
+	{ "NFFN", -17.755, 179.999 },
+};
+
+static double metres(const EuroScope::CPosition &a, const EuroScope::CPosition &b) {
+	return a.DistanceTo(b) * METRES_PER_NM;
+}
+
+int main() {
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> bearing(0, 2 * std::numbers::pi), unit(0, 1);
+	std::uniform_real_distribution<float> offset(-PAIR_SPAN / 2, PAIR_SPAN / 2);
+
+	bool ok = true;
+
+	std::printf("%-8s %12s %12s %12s\n", "origin", "origin m", "pair m", "round trip m");
+
+	for (const auto &o : ORIGINS) {
+		EuroScope::CPosition origin;
+		origin.m_Latitude = o.lat;
+		origin.m_Longitude = o.lon;
+
+		LocalFrame frame(origin);
+		double origin_error = 0, pair_error = 0, trip_error = 0;
+
+		for (int i = 0; i < SAMPLES; i++) {
+			// uniform over the disc, so the edge is sampled as much as any
+			double r = FRAME_RANGE * std::sqrt(unit(rng)), b = bearing(rng);
+			Vec2 a = { (float) (r * std::sin(b)), (float) (r * std::cos(b)) };
+			Vec2 c = { a.x + offset(rng), a.y + offset(rng) };
+
+			auto pa = frame.unproject(a), pc = frame.unproject(c);
+			auto qa = frame.project(pa), qc = frame.project(pc);
+
+			origin_error = std::max(origin_error, std::fabs(std::hypot(qa.x, qa.y) - metres(origin, pa)));
+			pair_error = std::max(pair_error, std::fabs(std::hypot(qc.x - qa.x, qc.y - qa.y) - metres(pa, pc)));
+			trip_error = std::max(trip_error, (double) std::hypot(qa.x - a.x, qa.y - a.y));
+		}
+
+		std::printf("%-8s %12.3f %12.3f %12.3f\n", o.name, origin_error, pair_error, trip_error);
+
+		if (origin_error > ORIGIN_TOLERANCE || pair_error > PAIR_TOLERANCE || trip_error > ROUND_TRIP_TOLERANCE) {
+			std::printf("%s: beyond tolerance of %g, %g and %g m\n", o.name, ORIGIN_TOLERANCE, PAIR_TOLERANCE, ROUND_TRIP_TOLERANCE);
+			ok = false;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
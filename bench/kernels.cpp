@@ -0,0 +1,96 @@
+// checks each kernel against the scalar version and times it, for every
+// instruction set this processor supports
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <chrono>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "kernels.hpp"
+
+const int REPEATS = 200;
+const std::size_t SIZES[] = { 64, 1024, 65536 };
+const int POLYGON_SIDES = 32;
+
+template<typename F>
+static double time_per_point(std::size_t n, F f) {
+	using namespace std::chrono;
+
+	f();
+
+	auto start = steady_clock::now();
+	for (int i = 0; i < REPEATS; i++) f();
+	auto elapsed = steady_clock::now() - start;
+
+	return duration<double, std::nano>(elapsed).count() / REPEATS / n;
+}
+
+int main() {
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> coord(-3000, 3000);
+
+	// a star-shaped polygon, so points land on both sides of many edges
+	std::vector<Vec2> poly;
+	for (int i = 0; i < POLYGON_SIDES; i++) {
+		float angle = 2 * std::numbers::pi_v<float> * i / POLYGON_SIDES;
+		float radius = i % 2 ? 1200 : 2400;
+		poly.push_back({ radius * std::cos(angle), radius * std::sin(angle) });
+	}
+
+	Vec2 start = { -500, -200 }, dir = { 0.8f, 0.6f }, centre = { 100, 50 };
+	bool ok = true;
+
+	std::printf("%-12s %-8s %8s %10s\n", "kernel", "isa", "points", "ns/point");
+
+	for (auto n : SIZES) {
+		std::vector<Vec2> points(n);
+		for (auto &p : points) p = { coord(rng), coord(rng) };
+
+		std::vector<std::uint8_t> expected_poly(n), expected_rect(n), inside(n);
+
+		kernels::select(kernels::ISA_SCALAR);
+		auto expected_count = kernels::count_near(points.data(), n, start, dir, 1500, 185);
+		kernels::in_polygon(points.data(), n, poly.data(), poly.size(), expected_poly.data());
+		kernels::in_rect(points.data(), n, centre, dir, 1800, 30, expected_rect.data());
+
+		for (int isa = kernels::ISA_SCALAR; isa <= kernels::supported(); isa++) {
+			kernels::select((kernels::Isa) isa);
+			const char *name = kernels::isa_name((kernels::Isa) isa);
+
+			std::size_t count;
+			double t = time_per_point(n, [&] {
+				count = kernels::count_near(points.data(), n, start, dir, 1500, 185);
+			});
+			std::printf("%-12s %-8s %8zu %10.3f\n", "count_near", name, n, t);
+			if (count != expected_count) {
+				std::printf("count_near: %s gave %zu, expected %zu\n", name, count, expected_count);
+				ok = false;
+			}
+
+			t = time_per_point(n, [&] {
+				kernels::in_polygon(points.data(), n, poly.data(), poly.size(), inside.data());
+			});
+			std::printf("%-12s %-8s %8zu %10.3f\n", "in_polygon", name, n, t);
+			if (std::memcmp(inside.data(), expected_poly.data(), n)) {
+				std::printf("in_polygon: %s disagrees with scalar\n", name);
+				ok = false;
+			}
+
+			t = time_per_point(n, [&] {
+				kernels::in_rect(points.data(), n, centre, dir, 1800, 30, inside.data());
+			});
+			std::printf("%-12s %-8s %8zu %10.3f\n", "in_rect", name, n, t);
+			if (std::memcmp(inside.data(), expected_rect.data(), n)) {
+				std::printf("in_rect: %s disagrees with scalar\n", name);
+				ok = false;
+			}
+		}
+	}
+
+	return ok ? 0 : 1;
+}
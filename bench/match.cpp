@@ -0,0 +1,134 @@
+// generates synthetic traffic that knows which taxiway each taxiing position
+// is on, replays it into the plugin, and reports how many of those positions
+// the plugin matched to the right taxiway
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <map>
+#include <string>
+
+#include "host/replay.hpp"
+#include "host/traffic.hpp"
+
+static int usage(const char *name) {
+	std::fprintf(
+		stderr,
+		"usage: %s [-a aerodrome] [-n aircraft] [-m minutes] [-s seed] [-j noise]\n"
+		"       [-r runway runway lat lon lat lon]... [-u runway] config\n",
+		name
+	);
+
+	return 2;
+}
+
+int main(int argc, char **argv) {
+	host::TrafficOptions options;
+	options.known = true;
+	int arg = 1;
+
+	for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] && !argv[arg][2]; arg += 2) {
+		char flag = argv[arg][1];
+		int values = flag == 'r' ? 6 : 1;
+		if (arg + values >= argc) return usage(argv[0]);
+
+		const char *value = argv[arg + 1];
+
+		switch (flag) {
+			case 'a': options.aerodrome = value; break;
+			case 'n': options.aircraft = std::atoi(value); break;
+			case 'm': options.minutes = std::atoi(value); break;
+			case 's': options.seed = std::strtoul(value, nullptr, 10); break;
+			case 'j': options.noise = std::atof(value); break;
+			case 'u': options.in_use = value; break;
+
+			case 'r': {
+				auto &rwy = options.runways.emplace_back();
+				rwy.name[0] = argv[arg + 1];
+				rwy.name[1] = argv[arg + 2];
+
+				for (int i = 0; i < 2; i++) {
+					if (!rwy.threshold[i].LoadFromStrings(argv[arg + 4 + 2 * i], argv[arg + 3 + 2 * i])) {
+						std::fprintf(stderr, "%s: bad threshold for %s\n", argv[0], rwy.name[i].c_str());
+						return 2;
+					}
+				}
+
+				arg += values - 1;
+				break;
+			}
+
+			default:
+				return usage(argv[0]);
+		}
+	}
+
+	if (argc - arg != 1) return usage(argv[0]);
+
+	const char *config = argv[arg];
+
+	host::Traffic traffic(options);
+	if (!traffic.load(config)) {
+		std::fprintf(stderr, "%s: %s\n", config, traffic.error.c_str());
+		return 1;
+	}
+
+	auto &w = host::world();
+	w.config = config;
+
+	host::Replay replay;
+	replay.open(traffic.generate());
+	replay.prelude();
+
+	auto *plugin = new Plugin();
+	auto *screen = plugin->OnRadarScreenCreated(ASR_TYPE, true, true, true, true);
+	replay.attach(plugin, screen);
+
+	// each known position is checked once every record up to its second has
+	// been played, by which time the plugin has matched it
+	std::uint64_t correct = 0, wrong = 0, unmatched = 0;
+	std::map<std::string, std::uint64_t> confused;
+
+	for (const auto &known : traffic.known) {
+		while (replay.next_time() <= known.time) replay.step();
+
+		auto *ac = w.find(known.callsign);
+		if (!ac) continue;
+
+		char string[16];
+		int colour;
+		COLORREF rgb;
+		double size;
+		plugin->OnGetTagItem(host::flight_plan(*ac), host::radar_target(*ac), TAG_ITEM_TAXIWAY, 0, string, &colour, &rgb, &size);
+
+		if (!string[0]) {
+			unmatched++;
+		} else if (known.taxiway == string) {
+			correct++;
+		} else {
+			wrong++;
+			confused[known.taxiway + " as " + string]++;
+		}
+	}
+
+	while (replay.step());
+
+	delete screen;
+	delete plugin;
+
+	auto total = correct + wrong + unmatched;
+	if (!total) {
+		std::fprintf(stderr, "%s: no taxiing positions to check\n", config);
+		return 1;
+	}
+
+	std::printf(
+		"%llu positions: %.1f%% on the right taxiway, %.1f%% on another, %.1f%% unmatched\n",
+		(unsigned long long) total, 100.0 * correct / total, 100.0 * wrong / total, 100.0 * unmatched / total
+	);
+
+	for (const auto &[pair, count] : confused) std::printf("  %s: %llu\n", pair.c_str(), (unsigned long long) count);
+
+	return 0;
+}
@@ -0,0 +1,657 @@
+// times the plugin's hooks and the lookups behind them natively, over
+// generated aerodromes and traffic. each benchmark is run several times and
+// the median kept, which is steady enough to compare against a baseline
+// saved from an earlier run and fail on regressions beyond a threshold
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numbers>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <time.h>
+
+#include "host/replay.hpp"
+#include "host/traffic.hpp"
+#include "kernels.hpp"
+
+const int REPEATS = 9;
+const auto SAMPLE_TIME = std::chrono::milliseconds(20);
+const double THRESHOLD = 10; // %
+
+const int SMALL_AERODROMES = 1, SMALL_STANDS = 50;
+const int LARGE_AERODROMES = 20, LARGE_STANDS = 400;
+const unsigned SCENE_AIRCRAFT[] = { 100, 1000 };
+const unsigned SCENE_MINUTES = 10;
+const unsigned CONFLICT_AIRCRAFT[] = { 100, 400, 1000 };
+const int CLOSED_AREAS[] = { 10, 100, 1000 };
+const unsigned CLOSED_AIRCRAFT = 200;
+const float CLOSED_SIZE = 40; // m across
+
+const int LOOKUPS = 1024;
+const int PRESSURE_AERODROMES = 1000;
+const float LOOKAHEAD = 250; // m
+
+// generated aerodromes are a runway along the x axis, a parallel taxiway
+// with junctions every JUNCTION_SPACING, and apron lanes beyond it with a
+// row of stands either side
+const float EXTENT = 1500; // m either side of the centre
+const float JUNCTION_SPACING = 250, TAXIWAY_Y = 200, HOLD_Y = 90; // m
+const float APRON_Y = 400, LANE_SPACING = 160, ROW_OFFSET = 45; // m
+const float STAND_SPACING = 60; // m
+const int JUNCTIONS = 13, STANDS_PER_ROW = 50;
+
+struct Site {
+	std::string name;
+	EuroScope::CPosition centre;
+	LocalFrame frame;
+	std::vector<Vec2> hotspots, stands;
+	host::TrafficRunway runway;
+};
+
+struct Result {
+	std::string name;
+	double median, low, high; // ns per op
+};
+
+static int repeats = REPEATS;
+static const char *filter = nullptr;
+static std::unordered_map<std::string, double> baseline;
+static std::vector<Result> results;
+static volatile std::size_t sink;
+
+// degrees as the configuration has them, e.g. N051.08.30.000
+static std::string coordinate(double deg, char positive, char negative) {
+	auto ms = std::llround(std::fabs(deg) * 3600000);
+
+	char buf[32];
+	std::snprintf(
+		buf, sizeof buf, "%c%03lld.%02lld.%02lld.%03lld",
+		deg < 0 ? negative : positive, ms / 3600000, ms / 60000 % 60, ms / 1000 % 60, ms % 1000
+	);
+
+	return buf;
+}
+
+static std::vector<Site> write_config(const std::string &path, int count, int stands, int closures = 0) {
+	std::ofstream os(path);
+	std::mt19937 rng(1);
+	std::vector<Site> sites;
+
+	int rows = (stands + STANDS_PER_ROW - 1) / STANDS_PER_ROW, lanes = (rows + 1) / 2;
+	auto junction = [](int i) { return -EXTENT + JUNCTION_SPACING * i; };
+	auto lane = [](int j) { return APRON_Y + LANE_SPACING * j; };
+
+	for (int k = 0; k < count; k++) {
+		auto &site = sites.emplace_back();
+		site.name = { 'Z', 'B', (char) ('A' + k / 26 % 26), (char) ('A' + k % 26) };
+		site.centre.m_Latitude = 50 + 0.2 * k;
+		site.centre.m_Longitude = 0;
+		site.frame = LocalFrame(site.centre);
+
+		auto at = [&](float x, float y) {
+			auto posn = site.frame.unproject({ x, y });
+			return coordinate(posn.m_Latitude, 'N', 'S') + " " + coordinate(posn.m_Longitude, 'E', 'W');
+		};
+
+		os << "A " << site.name << "\n";
+
+		for (int s = 0; s < stands; s++) os << "S " << s + 1 << " " << "ABCDEF"[s % 6] << "\n";
+
+		for (int s = 0; s < stands; s++) {
+			int row = s / STANDS_PER_ROW, col = s % STANDS_PER_ROW;
+			Vec2 p = { -EXTENT + STAND_SPACING * (col + 0.5f), lane(row / 2) + (row % 2 ? ROW_OFFSET : -ROW_OFFSET) };
+
+			site.stands.push_back(p);
+			os << "L " << s + 1 << " " << at(p.x, p.y) << " " << (char) ('A' + s % STAND_SIZES) << "\n";
+		}
+
+		os << "T A";
+		for (int i = 0; i < JUNCTIONS; i++) os << " " << at(junction(i), TAXIWAY_Y);
+		os << "\n";
+
+		for (int j = 0; j < lanes; j++) {
+			os << "T L" << j + 1;
+			for (int i = 0; i < JUNCTIONS; i++) os << " " << at(junction(i), lane(j));
+			os << "\n";
+		}
+
+		// connectors up through the lanes, with a hotspot where each leaves
+		// the parallel taxiway
+		for (int i = 1; i < JUNCTIONS; i += 2) {
+			os << "T C" << i << " " << at(junction(i), TAXIWAY_Y);
+			for (int j = 0; j < lanes; j++) os << " " << at(junction(i), lane(j));
+			os << "\n";
+
+			site.hotspots.push_back({ junction(i), TAXIWAY_Y });
+			os << "I HS" << i << " " << at(junction(i), TAXIWAY_Y) << "\n";
+		}
+
+		// links down to holding points at the ends and in between, each
+		// with a stop bar and a queue
+		for (int i = 0; i < JUNCTIONS; i += 4) {
+			float x = junction(i);
+			const char *rwy = x < 0 ? "09" : "27";
+
+			os << "T B" << i << " " << at(x, TAXIWAY_Y) << " " << at(x, HOLD_Y) << "\n";
+			os << "W " << rwy << " B" << i << " " << at(x, HOLD_Y) << "\n";
+			os << "B " << rwy << " B" << i << " " << at(x - 20, HOLD_Y + 10) << " " << at(x + 20, HOLD_Y + 10) << "\n";
+			os << "Q " << rwy << " B" << i << " " << at(x - 30, HOLD_Y) << " " << at(x + 30, HOLD_Y) << " "
+				<< at(x + 30, TAXIWAY_Y + 30) << " " << at(x - 30, TAXIWAY_Y + 30) << "\n";
+		}
+
+		// the end of the outermost lane is closed
+		float cx = (junction(JUNCTIONS - 2) + junction(JUNCTIONS - 1)) / 2, cy = lane(lanes - 1);
+		os << "C " << at(cx - 30, cy - 30) << " " << at(cx + 30, cy - 30) << " " << at(cx + 30, cy + 30) << " " << at(cx - 30, cy + 30) << "\n";
+
+		// and any more closures are scattered over the whole aerodrome
+		std::uniform_real_distribution<float> x(-EXTENT, EXTENT), y(0, EXTENT);
+		for (int i = 0; i < closures; i++) {
+			float cx = x(rng), cy = y(rng), h = CLOSED_SIZE / 2;
+			os << "C " << at(cx - h, cy - h) << " " << at(cx + h, cy - h) << " " << at(cx + h, cy + h) << " " << at(cx - h, cy + h) << "\n";
+		}
+
+		site.runway.name[0] = "09";
+		site.runway.name[1] = "27";
+		site.runway.threshold[0] = site.frame.unproject({ -EXTENT, 0 });
+		site.runway.threshold[1] = site.frame.unproject({ EXTENT, 0 });
+	}
+
+	return sites;
+}
+
+// the sector as EuroScope would have it, with every aerodrome and runway
+// active and all of them in range
+static void set_sector(const std::vector<Site> &sites) {
+	auto &w = host::world();
+
+	w.controller = sites[0].centre;
+	w.range = 1000;
+
+	for (const auto &site : sites) {
+		host::Element ad;
+		ad.type = EuroScope::SECTOR_ELEMENT_AIRPORT;
+		ad.name = site.name;
+		ad.position[0] = site.centre;
+		ad.active[0][0] = ad.active[0][1] = true;
+		w.elements.push_back(std::move(ad));
+
+		host::Element rwy;
+		rwy.type = EuroScope::SECTOR_ELEMENT_RUNWAY;
+		rwy.name = site.runway.name[0] + " - " + site.runway.name[1];
+		rwy.airport = site.name;
+
+		for (int i = 0; i < 2; i++) {
+			rwy.runway[i] = site.runway.name[i];
+			rwy.position[i] = site.runway.threshold[i];
+			rwy.active[i][0] = rwy.active[i][1] = true;
+		}
+
+		w.elements.push_back(std::move(rwy));
+	}
+}
+
+// anything the plugin complained about means the generated configuration or
+// sector is wrong, and the timings with it
+static void check_messages() {
+	auto &w = host::world();
+
+	for (const auto &msg : w.messages)
+		std::fprintf(stderr, "%s: %s: %s\n", msg.handler.c_str(), msg.sender.c_str(), msg.text.c_str());
+
+	w.messages.clear();
+}
+
+// processor time of this thread, which other processes being scheduled in
+// do not count towards
+static double thread_ns() {
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// times enough calls of f per sample to take SAMPLE_TIME, so that clock
+// resolution is small beside it, and keeps the median of the samples per op
+template<typename F>
+static void measure(const std::string &name, double ops, F f) {
+	using namespace std::chrono;
+
+	if (filter && name.find(filter) == std::string::npos) return;
+
+	f();
+
+	double start = thread_ns();
+	f();
+	double once = std::max(thread_ns() - start, 1.0);
+
+	long long calls = std::max(1.0, duration<double, std::nano>(SAMPLE_TIME).count() / once);
+	std::vector<double> samples;
+
+	for (int i = 0; i < repeats; i++) {
+		start = thread_ns();
+		for (long long c = 0; c < calls; c++) f();
+		samples.push_back((thread_ns() - start) / calls / ops);
+	}
+
+	std::sort(samples.begin(), samples.end());
+	const auto &result = results.emplace_back(Result { name, samples[samples.size() / 2], samples.front(), samples.back() });
+
+	std::printf("%-28s %12.1f %12.1f %12.1f", name.c_str(), result.median, result.low, result.high);
+
+	if (auto it = baseline.find(name); it != baseline.end())
+		std::printf(" %+8.1f%%", (result.median / std::get<1>(*it) - 1) * 100);
+
+	std::printf("\n");
+	std::fflush(stdout);
+}
+
+static void bench_load(const char *size, const std::string &config, const std::vector<Site> &sites) {
+	auto &w = host::world();
+
+	w.clear();
+	w.config = config;
+	set_sector(sites);
+
+	auto *plugin = new Plugin();
+	check_messages();
+
+	measure(std::string("load/") + size, 1, [&] { plugin->OnCompileCommand(".reloadvsmrplus"); });
+
+	delete plugin;
+	w.clear();
+}
+
+// replays some minutes of traffic at an aerodrome into a plugin, then times
+// its hooks with that traffic in place
+static void bench_scene(const std::string &config, const Site &site, unsigned aircraft) {
+	auto &w = host::world();
+	auto n = "/" + std::to_string(aircraft);
+
+	w.clear();
+	w.config = config;
+
+	host::TrafficOptions options;
+	options.aerodrome = site.name;
+	options.aircraft = aircraft;
+	options.minutes = SCENE_MINUTES;
+	options.runways = { site.runway };
+	options.in_use = site.runway.name[1];
+
+	host::Traffic traffic(options);
+	if (!traffic.load(config)) {
+		std::fprintf(stderr, "%s: %s\n", config.c_str(), traffic.error.c_str());
+		std::exit(2);
+	}
+
+	host::Replay replay;
+	replay.open(traffic.generate());
+	replay.prelude();
+
+	auto *plugin = new Plugin();
+	auto *screen = plugin->OnRadarScreenCreated(ASR_TYPE, true, true, true, true);
+	replay.attach(plugin, screen);
+
+	while (replay.step());
+	check_messages();
+
+	std::vector<std::pair<EuroScope::CFlightPlan, EuroScope::CRadarTarget>> handles;
+	for (const auto &ac : w.aircraft) handles.emplace_back(host::flight_plan(*ac), host::radar_target(*ac));
+
+	// every aircraft has its pressure setting checked, so each change of
+	// QNH makes them all due or no longer due
+	const char *metar[2] = {
+		"01000Z 24008KT 9999 SCT030 15/09 Q1013",
+		"01000Z 24008KT 9999 SCT030 15/09 Q1014",
+	};
+
+	plugin->OnNewMetarReceived(site.name.c_str(), metar[0]);
+
+	for (const auto &ac : w.aircraft) {
+		w.asel = ac->callsign;
+		plugin->OnFunctionCall(TAG_FUNC_PRESSURE_UPDATE, "", {}, w.radar_area);
+	}
+
+	measure("refresh" + n, 1, [&] { screen->OnRefresh(nullptr, EuroScope::REFRESH_PHASE_BEFORE_TAGS); });
+
+	for (const auto &[_, code] : w.tag_items) {
+		char string[16];
+		int colour;
+		COLORREF rgb;
+		double size;
+
+		measure("tag_item/" + std::to_string(code) + n, handles.size(), [&] {
+			for (const auto &[fp, rt] : handles) plugin->OnGetTagItem(fp, rt, code, 0, string, &colour, &rgb, &size);
+		});
+	}
+
+	int q = 0;
+	measure("metar" + n, 1, [&] {
+		q ^= 1;
+		plugin->OnNewMetarReceived(site.name.c_str(), metar[q]);
+	});
+
+	// every aircraft taxiing and dehighlighted; the check for missed
+	// dehighlights runs once a minute, so a minute of ticks is timed
+	for (const auto &ac : w.aircraft) {
+		ac->ground_state = "TAXI";
+		plugin->OnFlightPlanControllerAssignedDataUpdate(host::flight_plan(*ac), EuroScope::CTR_DATA_TYPE_GROUND_STATE);
+
+		w.asel = ac->callsign;
+		plugin->OnFunctionCall(TAG_FUNC_DEHIGHLIGHT, "", {}, w.radar_area);
+	}
+
+	int counter = 0;
+	measure("timer_minute" + n, 1, [&] {
+		for (int i = 0; i < DEHIGHLIGHT_CHECK_INTERVAL; i++) plugin->OnTimer(counter++);
+	});
+
+	w.messages.clear();
+
+	delete screen;
+	delete plugin;
+	w.clear();
+}
+
+// aircraft taxiing in every direction, at once and more densely than any
+// replay has them, for the conflict check each timer tick makes; the area
+// grows with the count so the density stays that of the largest, and the
+// time per aircraft holds steady if the check is linear
+static void bench_conflicts(const std::string &config, const std::vector<Site> &sites, unsigned aircraft) {
+	auto &w = host::world();
+	const auto &site = sites[0];
+
+	w.clear();
+	w.config = config;
+	set_sector(sites);
+
+	auto *plugin = new Plugin();
+	check_messages();
+
+	std::mt19937 rng(1);
+	float scale = std::sqrt((float) aircraft / CONFLICT_AIRCRAFT[std::size(CONFLICT_AIRCRAFT) - 1]);
+	std::uniform_real_distribution<float> x(-EXTENT * scale, EXTENT * scale), y(0, EXTENT * scale), track(0, 360);
+	std::uniform_int_distribution<int> gs(5, 25);
+
+	for (unsigned i = 0; i < aircraft; i++) {
+		auto &ac = w.add("BENCH" + std::to_string(i));
+		ac.position = site.frame.unproject({ x(rng), y(rng) });
+		ac.track = track(rng);
+		ac.gs = gs(rng);
+		ac.ground_state = "TAXI";
+
+		plugin->OnRadarTargetPositionUpdate(host::radar_target(ac));
+	}
+
+	int counter = 0;
+	measure("conflicts/" + std::to_string(aircraft), aircraft, [&] { plugin->OnTimer(counter++); });
+
+	check_messages();
+
+	delete plugin;
+	w.clear();
+}
+
+// position updates of aircraft taxiing among many closed areas, each of
+// which must be tested for incursions; timed per update, which holds steady
+// while the closed area index keeps the test independent of their number
+static void bench_closed(const std::string &config, const std::vector<Site> &sites, int closures) {
+	auto &w = host::world();
+	const auto &site = sites[0];
+	auto n = "/" + std::to_string(closures);
+
+	w.clear();
+	w.config = config;
+	set_sector(sites);
+
+	auto *plugin = new Plugin();
+	check_messages();
+
+	measure("load/closed" + n, 1, [&] { plugin->OnCompileCommand(".reloadvsmrplus"); });
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> x(-EXTENT, EXTENT), y(0, EXTENT), track(0, 360);
+
+	std::vector<std::array<EuroScope::CPosition, 2>> positions;
+	for (unsigned i = 0; i < CLOSED_AIRCRAFT; i++) {
+		auto &ac = w.add("BENCH" + std::to_string(i));
+		ac.track = track(rng);
+		ac.gs = 10;
+		ac.ground_state = "TAXI";
+
+		// back and forth a few metres along its track
+		Vec2 p = { x(rng), y(rng) };
+		float t = ac.track * std::numbers::pi / 180.0;
+		positions.push_back({ site.frame.unproject(p), site.frame.unproject({ p.x + 5 * std::sin(t), p.y + 5 * std::cos(t) }) });
+	}
+
+	int step = 0;
+	measure("closed" + n, CLOSED_AIRCRAFT, [&] {
+		step ^= 1;
+
+		for (unsigned i = 0; i < CLOSED_AIRCRAFT; i++) {
+			auto &ac = *w.aircraft[i];
+			ac.position = positions[i][step];
+			plugin->OnRadarTargetPositionUpdate(host::radar_target(ac));
+		}
+	});
+
+	check_messages();
+
+	delete plugin;
+	w.clear();
+}
+
+// the lookups made on each position update and tag item: the hotspot
+// search on its own, and the stand and pressure lookups through the hooks
+// that make them
+static void bench_lookups(const std::string &config, const std::vector<Site> &sites) {
+	const auto &site = sites[0];
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> coord(-EXTENT, EXTENT), angle(0, 2 * std::numbers::pi_v<float>), jitter(-20, 20);
+
+	std::vector<Vec2> points(LOOKUPS), dirs(LOOKUPS);
+	for (int i = 0; i < LOOKUPS; i++) {
+		float a = angle(rng);
+		points[i] = { coord(rng), coord(rng) / 2 + EXTENT / 2 };
+		dirs[i] = { std::sin(a), std::cos(a) };
+	}
+
+	// as update_warn does, through the grid and then the kernel per cell
+	PointGrid hotspots { HOTSPOT_CELL };
+	for (const auto &p : site.hotspots) hotspots.insert(p);
+	hotspots.build();
+
+	measure("lookup/hotspot", LOOKUPS, [&] {
+		std::size_t near = 0;
+		for (int i = 0; i < LOOKUPS; i++) {
+			Vec2 start = points[i], end = { start.x + dirs[i].x * LOOKAHEAD, start.y + dirs[i].y * LOOKAHEAD };
+
+			hotspots.query(
+				std::min(start.x, end.x) - WARN_DIST, std::min(start.y, end.y) - WARN_DIST,
+				std::max(start.x, end.x) + WARN_DIST, std::max(start.y, end.y) + WARN_DIST,
+				[&](const Vec2 *spots, size_t n) { near += kernels::count_near(spots, n, start, dirs[i], LOOKAHEAD, WARN_DIST); }
+			);
+		}
+
+		sink = near;
+	});
+
+	// the rest through a plugin with the aerodromes loaded
+	auto &w = host::world();
+
+	w.clear();
+	w.config = config;
+	set_sector(sites);
+
+	auto *plugin = new Plugin();
+	check_messages();
+
+	// stationary aircraft moved between two stands, so each position update
+	// searches for the nearest stand afresh
+	std::uniform_int_distribution<std::size_t> stand(0, site.stands.size() - 1);
+	std::vector<std::array<EuroScope::CPosition, 2>> positions;
+
+	for (int i = 0; i < LOOKUPS; i++) {
+		auto &ac = w.add("STAND" + std::to_string(i));
+		auto &at = positions.emplace_back();
+
+		for (auto &posn : at) {
+			const auto &s = site.stands[stand(rng)];
+			posn = site.frame.unproject({ s.x + jitter(rng), s.y + jitter(rng) });
+		}
+
+		ac.position = at[0];
+		plugin->OnRadarTargetPositionUpdate(host::radar_target(ac));
+	}
+
+	int step = 0;
+	measure("lookup/stand", LOOKUPS, [&] {
+		step ^= 1;
+
+		for (int i = 0; i < LOOKUPS; i++) {
+			auto &ac = *w.aircraft[i];
+			ac.position = positions[i][step];
+			plugin->OnRadarTargetPositionUpdate(host::radar_target(ac));
+		}
+	});
+
+	// by origin, as each pressure tag item looks it up; a tenth of origins
+	// have had no metar, so their aircraft never have a setting to check
+	auto icao = [](int i) { return std::string { 'Z', (char) ('A' + i / 676 % 26), (char) ('A' + i / 26 % 26), (char) ('A' + i % 26) }; };
+
+	for (int i = 0; i < PRESSURE_AERODROMES; i++)
+		plugin->OnNewMetarReceived(icao(i).c_str(), "01000Z 24008KT 9999 SCT030 15/09 Q1013");
+
+	std::uniform_int_distribution<int> origin(0, PRESSURE_AERODROMES * 11 / 10);
+	std::vector<EuroScope::CFlightPlan> fps;
+
+	for (int i = 0; i < LOOKUPS; i++) {
+		auto &ac = w.add("QNH" + std::to_string(i));
+		ac.origin = icao(origin(rng));
+
+		w.asel = ac.callsign;
+		plugin->OnFunctionCall(TAG_FUNC_PRESSURE_UPDATE, "", {}, w.radar_area);
+
+		fps.push_back(host::flight_plan(ac));
+	}
+
+	measure("lookup/pressure", LOOKUPS, [&] {
+		char string[16];
+		int colour;
+		COLORREF rgb;
+		double size;
+
+		for (auto fp : fps) plugin->OnGetTagItem(fp, {}, TAG_ITEM_PRESSURE, 0, string, &colour, &rgb, &size);
+	});
+
+	check_messages();
+
+	delete plugin;
+	w.clear();
+}
+
+static int usage(const char *name) {
+	std::fprintf(stderr, "usage: %s [-r repeats] [-f filter] [-b baseline] [-t threshold] [-o save]\n", name);
+	return 2;
+}
+
+int main(int argc, char **argv) {
+	const char *baseline_path = nullptr, *save_path = nullptr;
+	double threshold = THRESHOLD;
+
+	for (int arg = 1; arg < argc; arg += 2) {
+		if (arg + 1 >= argc || argv[arg][0] != '-' || !argv[arg][1] || argv[arg][2]) return usage(argv[0]);
+
+		const char *value = argv[arg + 1];
+
+		switch (argv[arg][1]) {
+			case 'r': repeats = std::max(1, std::atoi(value)); break;
+			case 'f': filter = value; break;
+			case 'b': baseline_path = value; break;
+			case 't': threshold = std::atof(value); break;
+			case 'o': save_path = value; break;
+			default: return usage(argv[0]);
+		}
+	}
+
+	// a baseline is lines of a benchmark name and its median ns per op, as
+	// saved by -o
+	if (baseline_path) {
+		std::ifstream is(baseline_path);
+		if (!is) {
+			std::fprintf(stderr, "%s: cannot open\n", baseline_path);
+			return 2;
+		}
+
+		std::string name;
+		double median;
+		while (is >> name >> median) baseline[name] = median;
+	}
+
+	auto dir = std::filesystem::temp_directory_path();
+	auto small_config = (dir / "vsmrplus-bench-small.txt").string();
+	auto large_config = (dir / "vsmrplus-bench-large.txt").string();
+
+	auto small = write_config(small_config, SMALL_AERODROMES, SMALL_STANDS);
+	auto large = write_config(large_config, LARGE_AERODROMES, LARGE_STANDS);
+
+	std::printf("%-28s %12s %12s %12s%s\n", "benchmark", "ns/op", "min", "max", baseline.empty() ? "" : "    change");
+
+	bench_load("small", small_config, small);
+	bench_load("large", large_config, large);
+
+	for (auto aircraft : SCENE_AIRCRAFT) bench_scene(large_config, large[0], aircraft);
+	for (auto aircraft : CONFLICT_AIRCRAFT) bench_conflicts(large_config, large, aircraft);
+
+	for (auto closures : CLOSED_AREAS) {
+		auto config = (dir / "vsmrplus-bench-closed.txt").string();
+		auto sites = write_config(config, SMALL_AERODROMES, SMALL_STANDS, closures);
+
+		bench_closed(config, sites, closures);
+		std::filesystem::remove(config);
+	}
+
+	bench_lookups(large_config, large);
+
+	std::filesystem::remove(small_config);
+	std::filesystem::remove(large_config);
+
+	if (save_path) {
+		auto file = std::fopen(save_path, "w");
+		if (!file) {
+			std::fprintf(stderr, "%s: cannot write\n", save_path);
+			return 2;
+		}
+
+		for (const auto &result : results) std::fprintf(file, "%s %.1f\n", result.name.c_str(), result.median);
+		std::fclose(file);
+	}
+
+	int regressions = 0;
+	for (const auto &result : results) {
+		auto it = baseline.find(result.name);
+		if (it == baseline.end() || result.median <= std::get<1>(*it) * (1 + threshold / 100)) continue;
+
+		std::printf("%s: %.1f ns/op against %.1f in the baseline\n", result.name.c_str(), result.median, std::get<1>(*it));
+		regressions++;
+	}
+
+	if (regressions) {
+		std::printf("%d regressed by more than %g%%\n", regressions, threshold);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+// replays a session log into the plugin natively, as fast as it will go or
+// at some multiple of real time, and reports how long each hook took as JSON
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <sys/resource.h>
+
+#include "host/replay.hpp"
+
+static double to_seconds(const timeval &tv) {
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double or_zero(double value) {
+	return std::isfinite(value) ? value : 0;
+}
+
+int main(int argc, char **argv) {
+	using namespace std::chrono;
+
+	double speed = 0;
+	int arg = 1;
+
+	if (arg + 1 < argc && !std::strcmp(argv[arg], "-s")) {
+		speed = std::atof(argv[arg + 1]);
+		arg += 2;
+	}
+
+	if (argc - arg != 2) {
+		std::fprintf(stderr, "usage: %s [-s speed] config session\n", argv[0]);
+		return 2;
+	}
+
+	const char *config = argv[arg], *session = argv[arg + 1];
+
+	host::world().config = config;
+
+	host::Replay replay;
+	if (!replay.open(session)) {
+		std::fprintf(stderr, "%s: not a session log\n", session);
+		return 1;
+	}
+
+	replay.prelude();
+
+	auto start = steady_clock::now();
+
+	auto *plugin = new Plugin();
+	auto *screen = plugin->OnRadarScreenCreated(ASR_TYPE, true, true, true, true);
+	replay.attach(plugin, screen);
+
+	auto loaded = steady_clock::now();
+
+	// at a given speed, each record waits for its time; otherwise the log is
+	// played back to back
+	for (;;) {
+		auto time = replay.next_time();
+		if (time == UINT32_MAX) break;
+
+		if (speed > 0) std::this_thread::sleep_until(loaded + duration<double, std::milli>(time / speed));
+
+		replay.step();
+	}
+
+	auto finished = steady_clock::now();
+
+	delete screen;
+	delete plugin;
+
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	std::printf("{\n");
+	std::printf("\t\"session\": \"%s\",\n", session);
+	std::printf("\t\"speed\": %g,\n", speed);
+	std::printf("\t\"records\": %llu,\n", (unsigned long long) replay.records);
+	std::printf("\t\"peak_aircraft\": %zu,\n", replay.peak_aircraft);
+	std::printf("\t\"load_ms\": %.3f,\n", duration<double, std::milli>(loaded - start).count());
+	std::printf("\t\"wall_s\": %.3f,\n", duration<double>(finished - start).count());
+	std::printf("\t\"cpu_s\": %.3f,\n", to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime));
+	std::printf("\t\"peak_rss_kb\": %ld,\n", usage.ru_maxrss);
+	std::printf("\t\"hooks\": {\n");
+
+	for (int i = 0; i < host::HOOK_COUNT; i++) {
+		const auto &times = replay.times[i];
+
+		std::printf(
+			"\t\t\"%s\": { \"calls\": %llu, \"total_ms\": %.3f, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f }%s\n",
+			host::HOOK_NAMES[i],
+			(unsigned long long) times.calls,
+			duration<double, std::milli>(times.total).count(),
+			times.calls ? duration<double, std::micro>(times.total).count() / times.calls : 0,
+			or_zero(times.p50.value()),
+			or_zero(times.p99.value()),
+			duration<double, std::micro>(times.max).count(),
+			i + 1 < host::HOOK_COUNT ? "," : ""
+		);
+	}
+
+	std::printf("\t}\n");
+	std::printf("}\n");
+
+	return 0;
+}
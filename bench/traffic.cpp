@@ -0,0 +1,88 @@
+// generates a session log of synthetic surface traffic from a configuration,
+// for replaying into the plugin at traffic levels no recording has
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fstream>
+#include <string>
+
+#include "host/traffic.hpp"
+
+static int usage(const char *name) {
+	std::fprintf(
+		stderr,
+		"usage: %s [-a aerodrome] [-n aircraft] [-m minutes] [-s seed] [-j noise]\n"
+		"       [-r runway runway lat lon lat lon]... [-u runway] config session\n",
+		name
+	);
+
+	return 2;
+}
+
+int main(int argc, char **argv) {
+	host::TrafficOptions options;
+	int arg = 1;
+
+	for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] && !argv[arg][2]; arg += 2) {
+		char flag = argv[arg][1];
+		int values = flag == 'r' ? 6 : 1;
+		if (arg + values >= argc) return usage(argv[0]);
+
+		const char *value = argv[arg + 1];
+
+		switch (flag) {
+			case 'a': options.aerodrome = value; break;
+			case 'n': options.aircraft = std::atoi(value); break;
+			case 'm': options.minutes = std::atoi(value); break;
+			case 's': options.seed = std::strtoul(value, nullptr, 10); break;
+			case 'j': options.noise = std::atof(value); break;
+			case 'u': options.in_use = value; break;
+
+			case 'r': {
+				auto &rwy = options.runways.emplace_back();
+				rwy.name[0] = argv[arg + 1];
+				rwy.name[1] = argv[arg + 2];
+
+				for (int i = 0; i < 2; i++) {
+					if (!rwy.threshold[i].LoadFromStrings(argv[arg + 4 + 2 * i], argv[arg + 3 + 2 * i])) {
+						std::fprintf(stderr, "%s: bad threshold for %s\n", argv[0], rwy.name[i].c_str());
+						return 2;
+					}
+				}
+
+				arg += values - 1;
+				break;
+			}
+
+			default:
+				return usage(argv[0]);
+		}
+	}
+
+	if (argc - arg != 2) return usage(argv[0]);
+
+	const char *config = argv[arg], *session = argv[arg + 1];
+
+	host::Traffic traffic(options);
+	if (!traffic.load(config)) {
+		std::fprintf(stderr, "%s: %s\n", config, traffic.error.c_str());
+		return 1;
+	}
+
+	auto log = traffic.generate();
+
+	std::ofstream file(session, std::ios::binary);
+	if (!file.write(log.data(), log.size())) {
+		std::fprintf(stderr, "%s: cannot write\n", session);
+		return 1;
+	}
+
+	std::fprintf(
+		stderr, "%s: %llu aircraft, at most %llu at once, %zu bytes\n",
+		session, (unsigned long long) traffic.spawned, (unsigned long long) traffic.peak, log.size()
+	);
+
+	return 0;
+}
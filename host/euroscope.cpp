@@ -0,0 +1,490 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <numbers>
+#include <utility>
+
+#include "host.hpp"
+
+namespace host {
+
+World &world() {
+	static World instance;
+	return instance;
+}
+
+Aircraft *World::find(std::string_view callsign) {
+	auto it = by_callsign.find(std::string(callsign));
+	return it == by_callsign.end() ? nullptr : std::get<1>(*it);
+}
+
+Aircraft &World::add(std::string_view callsign) {
+	if (auto ac = find(callsign)) return *ac;
+
+	auto &ac = *aircraft.emplace_back(std::make_unique<Aircraft>());
+	ac.callsign = callsign;
+	ac.index = aircraft.size() - 1;
+	by_callsign[ac.callsign] = &ac;
+
+	return ac;
+}
+
+// swaps the last aircraft into the gap; aircraft never move in memory, so
+// handles to the others stay valid
+void World::remove(std::string_view callsign) {
+	auto ac = find(callsign);
+	if (!ac) return;
+
+	by_callsign.erase(ac->callsign);
+
+	auto i = ac->index;
+	std::swap(aircraft[i], aircraft.back());
+	aircraft[i]->index = i;
+	aircraft.pop_back();
+}
+
+// everything but the configuration, ready for another plugin to be created
+void World::clear() {
+	aircraft.clear();
+	by_callsign.clear();
+	elements.clear();
+	lists.clear();
+	tag_items.clear();
+	tag_functions.clear();
+	messages.clear();
+	popup.clear();
+	asel.clear();
+}
+
+EuroScope::CFlightPlan flight_plan(const Aircraft &ac) {
+	return world().plugin->FlightPlanSelect(ac.callsign.c_str());
+}
+
+EuroScope::CRadarTarget radar_target(const Aircraft &ac) {
+	return world().plugin->RadarTargetSelect(ac.callsign.c_str());
+}
+
+static Aircraft *of(ESINDEX index) {
+	return (Aircraft *) index;
+}
+
+// either sector file style, as N051.28.39.000, or decimal degrees
+static bool parse_coord(const char *text, char positive, char negative, double &value) {
+	if (!text || !*text) return false;
+
+	if (*text == positive || *text == negative) {
+		int degrees, minutes;
+		double seconds;
+		if (std::sscanf(text + 1, "%d.%d.%lf", &degrees, &minutes, &seconds) != 3) return false;
+
+		value = degrees + minutes / 60.0 + seconds / 3600.0;
+		if (*text == negative) value = -value;
+
+		return true;
+	}
+
+	char *end;
+	value = std::strtod(text, &end);
+	return !*end;
+}
+
+}
+
+namespace EuroScopePlugIn {
+
+using host::of;
+using host::world;
+
+const double EARTH_RADIUS_NM = 3440.065;
+
+bool CPosition::LoadFromStrings(const char *lon, const char *lat) {
+	double x, y;
+	if (!host::parse_coord(lon, 'E', 'W', x) || !host::parse_coord(lat, 'N', 'S', y)) return false;
+
+	m_Longitude = x;
+	m_Latitude = y;
+
+	return true;
+}
+
+double CPosition::DistanceTo(const CPosition other) const {
+	double k = std::numbers::pi / 180.0;
+	double dlat = (other.m_Latitude - m_Latitude) * k, dlon = (other.m_Longitude - m_Longitude) * k;
+
+	double a = std::sin(dlat / 2) * std::sin(dlat / 2)
+		+ std::cos(m_Latitude * k) * std::cos(other.m_Latitude * k) * std::sin(dlon / 2) * std::sin(dlon / 2);
+
+	return 2 * EARTH_RADIUS_NM * std::asin(std::min(std::sqrt(a), 1.0));
+}
+
+double CPosition::DirectionTo(const CPosition other) const {
+	double k = std::numbers::pi / 180.0;
+	double lat1 = m_Latitude * k, lat2 = other.m_Latitude * k, dlon = (other.m_Longitude - m_Longitude) * k;
+
+	double y = std::sin(dlon) * std::cos(lat2);
+	double x = std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(dlon);
+
+	return std::fmod(std::atan2(y, x) / k + 360, 360);
+}
+
+int CFlightPlanPositionPredictions::GetPointsNumber() const {
+	return of(m_FpPosition)->predictions.size();
+}
+
+CPosition CFlightPlanPositionPredictions::GetPosition(int i) const {
+	return of(m_FpPosition)->predictions[i];
+}
+
+int CFlightPlanPositionPredictions::GetAltitude(int) const {
+	return of(m_FpPosition)->altitude;
+}
+
+CPosition CRadarTargetPositionData::GetPosition() const {
+	return of(m_RtPosition)->position;
+}
+
+int CRadarTargetPositionData::GetPressureAltitude() const {
+	return of(m_RtPosition)->altitude;
+}
+
+const char *CFlightPlanData::GetOrigin() const {
+	return of(m_FpPosition)->origin.c_str();
+}
+
+const char *CFlightPlanData::GetDestination() const {
+	return of(m_FpPosition)->destination.c_str();
+}
+
+const char *CFlightPlanData::GetDepartureRwy() const {
+	return of(m_FpPosition)->departure_rwy.c_str();
+}
+
+const char *CFlightPlanData::GetArrivalRwy() const {
+	return of(m_FpPosition)->arrival_rwy.c_str();
+}
+
+char CFlightPlanData::GetEngineType() const {
+	return of(m_FpPosition)->engine_type;
+}
+
+char CFlightPlanData::GetAircraftWtc() const {
+	return of(m_FpPosition)->wtc;
+}
+
+const char *CFlightPlanControllerAssignedData::GetScratchPadString() const {
+	return of(m_FpPosition)->scratch_pad.c_str();
+}
+
+bool CFlightPlanControllerAssignedData::SetScratchPadString(const char *text) {
+	of(m_FpPosition)->scratch_pad = text;
+	return true;
+}
+
+const char *CFlightPlanControllerAssignedData::GetFlightStripAnnotation(int i) const {
+	return i >= 0 && i < 9 ? of(m_FpPosition)->annotations[i].c_str() : "";
+}
+
+bool CFlightPlanControllerAssignedData::SetFlightStripAnnotation(int i, const char *text) {
+	if (i < 0 || i >= 9) return false;
+
+	of(m_FpPosition)->annotations[i] = text;
+	return true;
+}
+
+const char *CFlightPlan::GetCallsign() const {
+	return of(m_FpPosition)->callsign.c_str();
+}
+
+double CFlightPlan::GetDistanceFromOrigin() const {
+	return of(m_FpPosition)->from_origin;
+}
+
+double CFlightPlan::GetDistanceToDestination() const {
+	return of(m_FpPosition)->to_destination;
+}
+
+const char *CFlightPlan::GetGroundState() const {
+	return of(m_FpPosition)->ground_state.c_str();
+}
+
+CFlightPlanData CFlightPlan::GetFlightPlanData() const {
+	CFlightPlanData data;
+	data.m_FpPosition = m_FpPosition;
+	return data;
+}
+
+CFlightPlanControllerAssignedData CFlightPlan::GetControllerAssignedData() const {
+	CFlightPlanControllerAssignedData data;
+	data.m_FpPosition = m_FpPosition;
+	return data;
+}
+
+CRadarTargetPositionData CFlightPlan::GetFPTrackPosition() const {
+	CRadarTargetPositionData posn;
+	posn.m_RtPosition = posn.m_PosPosition = m_FpPosition;
+	return posn;
+}
+
+CFlightPlanPositionPredictions CFlightPlan::GetPositionPredictions() const {
+	CFlightPlanPositionPredictions predictions;
+	predictions.m_FpPosition = m_FpPosition;
+	return predictions;
+}
+
+const char *CRadarTarget::GetCallsign() const {
+	return of(m_RtPosition)->callsign.c_str();
+}
+
+double CRadarTarget::GetTrackHeading() const {
+	return of(m_RtPosition)->track;
+}
+
+int CRadarTarget::GetGS() const {
+	return of(m_RtPosition)->gs;
+}
+
+CRadarTargetPositionData CRadarTarget::GetPosition() const {
+	CRadarTargetPositionData posn;
+	posn.m_RtPosition = posn.m_PosPosition = m_RtPosition;
+	return posn;
+}
+
+CFlightPlan CRadarTarget::GetCorrelatedFlightPlan() const {
+	CFlightPlan fp;
+	if (of(m_RtPosition)->flight_plan) fp.m_FpPosition = m_RtPosition;
+	return fp;
+}
+
+const char *CController::GetCallsign() const {
+	return "HOST";
+}
+
+CPosition CController::GetPosition() const {
+	return world().controller;
+}
+
+int CController::GetRange() const {
+	return world().range;
+}
+
+int CFlightPlanList::GetColumnNumber() {
+	return ((host::FpList *) m_Position)->columns;
+}
+
+void CFlightPlanList::AddColumnDefinition(const char *, int, bool, const char *, int, const char *, int, const char *, int) {
+	((host::FpList *) m_Position)->columns++;
+}
+
+void CFlightPlanList::AddFpToTheList(CFlightPlan fp) {
+	((host::FpList *) m_Position)->callsigns.insert(fp.GetCallsign());
+}
+
+void CFlightPlanList::RemoveFpFromTheList(CFlightPlan fp) {
+	((host::FpList *) m_Position)->callsigns.erase(fp.GetCallsign());
+}
+
+const char *CSectorElement::GetName() const {
+	return world().elements[m_Position].name.c_str();
+}
+
+const char *CSectorElement::GetAirportName() const {
+	return world().elements[m_Position].airport.c_str();
+}
+
+const char *CSectorElement::GetRunwayName(int i) const {
+	return world().elements[m_Position].runway[i].c_str();
+}
+
+bool CSectorElement::GetPosition(CPosition *posn, int i) {
+	const auto &el = world().elements[m_Position];
+	if (i < 0 || i > (el.type == SECTOR_ELEMENT_RUNWAY ? 1 : 0)) return false;
+
+	*posn = el.position[i];
+	return true;
+}
+
+bool CSectorElement::IsElementActive(bool departure, int i) {
+	return world().elements[m_Position].active[i][departure];
+}
+
+// the display area is drawn unrotated across the radar area, north up
+CRadarScreen::CRadarScreen() {
+	m_pRadarView = nullptr;
+	m_pPlugIn = nullptr;
+}
+
+RECT CRadarScreen::GetRadarArea() {
+	return world().radar_area;
+}
+
+void CRadarScreen::GetDisplayArea(CPosition *sw, CPosition *ne) {
+	*sw = world().display_sw;
+	*ne = world().display_ne;
+}
+
+POINT CRadarScreen::ConvertCoordFromPositionToPixel(CPosition posn) {
+	const auto &w = world();
+	const auto &area = w.radar_area;
+
+	double width = w.display_ne.m_Longitude - w.display_sw.m_Longitude;
+	double height = w.display_ne.m_Latitude - w.display_sw.m_Latitude;
+	if (width <= 0 || height <= 0) return { area.left, area.bottom };
+
+	return {
+		area.left + std::lround((posn.m_Longitude - w.display_sw.m_Longitude) / width * (area.right - area.left)),
+		area.bottom - std::lround((posn.m_Latitude - w.display_sw.m_Latitude) / height * (area.bottom - area.top)),
+	};
+}
+
+CPosition CRadarScreen::ConvertCoordFromPixelToPosition(POINT p) {
+	const auto &w = world();
+	const auto &area = w.radar_area;
+
+	CPosition posn;
+	if (area.right <= area.left || area.bottom <= area.top) return posn;
+
+	posn.m_Longitude = w.display_sw.m_Longitude
+		+ (double) (p.x - area.left) / (area.right - area.left) * (w.display_ne.m_Longitude - w.display_sw.m_Longitude);
+	posn.m_Latitude = w.display_sw.m_Latitude
+		+ (double) (area.bottom - p.y) / (area.bottom - area.top) * (w.display_ne.m_Latitude - w.display_sw.m_Latitude);
+
+	return posn;
+}
+
+void CRadarScreen::AddScreenObject(int, const char *, RECT, bool, const char *) {}
+
+CPlugIn::CPlugIn(int, const char *, const char *, const char *, const char *) {
+	m_pPluginData = nullptr;
+	world().plugin = this;
+}
+
+CPlugIn::~CPlugIn() {
+	if (world().plugin == this) world().plugin = nullptr;
+}
+
+void CPlugIn::RegisterTagItemType(const char *name, int code) {
+	world().tag_items.emplace_back(name, code);
+}
+
+void CPlugIn::RegisterTagItemFunction(const char *name, int code) {
+	world().tag_functions.emplace_back(name, code);
+}
+
+CFlightPlanList CPlugIn::RegisterFpList(const char *name) {
+	auto &lists = world().lists;
+
+	auto it = std::find_if(lists.begin(), lists.end(), [&](const auto &list) { return list->name == name; });
+	if (it == lists.end()) {
+		lists.push_back(std::make_unique<host::FpList>());
+		lists.back()->name = name;
+		it = lists.end() - 1;
+	}
+
+	CFlightPlanList list;
+	list.m_Position = it->get();
+	return list;
+}
+
+void CPlugIn::OpenPopupEdit(RECT, int, const char *initial) {
+	world().popup_edit = initial;
+}
+
+void CPlugIn::OpenPopupList(RECT, const char *, int) {
+	world().popup.clear();
+}
+
+void CPlugIn::AddPopupListElement(const char *first, const char *second, int function, bool, int, bool, bool) {
+	world().popup.push_back({ first, second, function });
+}
+
+CFlightPlan CPlugIn::FlightPlanSelect(const char *callsign) const {
+	CFlightPlan fp;
+	auto ac = world().find(callsign);
+	if (ac && ac->flight_plan) fp.m_FpPosition = ac;
+	return fp;
+}
+
+CRadarTarget CPlugIn::RadarTargetSelect(const char *callsign) const {
+	CRadarTarget rt;
+	rt.m_RtPosition = world().find(callsign);
+	return rt;
+}
+
+// the first aircraft with a flight plan from the index given
+static host::Aircraft *flight_plan_from(size_t i) {
+	const auto &aircraft = world().aircraft;
+	while (i < aircraft.size() && !aircraft[i]->flight_plan) i++;
+
+	return i < aircraft.size() ? aircraft[i].get() : nullptr;
+}
+
+CFlightPlan CPlugIn::FlightPlanSelectFirst() const {
+	CFlightPlan fp;
+	fp.m_FpPosition = flight_plan_from(0);
+	return fp;
+}
+
+CFlightPlan CPlugIn::FlightPlanSelectNext(CFlightPlan current) const {
+	CFlightPlan fp;
+	fp.m_FpPosition = flight_plan_from(of(current.m_FpPosition)->index + 1);
+	return fp;
+}
+
+CRadarTarget CPlugIn::RadarTargetSelectFirst() const {
+	CRadarTarget rt;
+	if (!world().aircraft.empty()) rt.m_RtPosition = world().aircraft.front().get();
+	return rt;
+}
+
+CRadarTarget CPlugIn::RadarTargetSelectNext(CRadarTarget current) const {
+	CRadarTarget rt;
+	auto i = of(current.m_RtPosition)->index + 1;
+	if (i < world().aircraft.size()) rt.m_RtPosition = world().aircraft[i].get();
+	return rt;
+}
+
+CFlightPlan CPlugIn::FlightPlanSelectASEL() const {
+	return FlightPlanSelect(world().asel.c_str());
+}
+
+CRadarTarget CPlugIn::RadarTargetSelectASEL() const {
+	return RadarTargetSelect(world().asel.c_str());
+}
+
+CController CPlugIn::ControllerMyself() const {
+	CController ctr;
+	ctr.m_CtrPosition = &world();
+	ctr.m_Myself = true;
+	return ctr;
+}
+
+CSectorElement CPlugIn::SectorFileElementSelectFirst(int type) const {
+	CSectorElement el;
+	el.m_Position = -1;
+	el.m_ElementType = type;
+	return SectorFileElementSelectNext(el, type);
+}
+
+CSectorElement CPlugIn::SectorFileElementSelectNext(CSectorElement current, int type) const {
+	const auto &elements = world().elements;
+
+	CSectorElement el;
+	el.m_ElementType = type;
+
+	for (int i = current.m_Position + 1; i < (int) elements.size(); i++) {
+		if (elements[i].type == type) {
+			el.m_Position = i;
+			break;
+		}
+	}
+
+	return el;
+}
+
+void CPlugIn::DisplayUserMessage(const char *handler, const char *sender, const char *text, bool, bool, bool, bool, bool) {
+	world().messages.push_back({ handler, sender, text });
+}
+
+}
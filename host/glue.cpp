@@ -0,0 +1,22 @@
+#include "host.hpp"
+#include "plugin.hpp"
+
+// what vsmrplus.cpp does on Windows, without the drawing itself; draw still
+// does all the work of finding what to draw, and where
+
+std::string config_path() {
+	return host::world().config;
+}
+
+void Screen::OnAsrContentToBeClosed() {
+	delete this;
+}
+
+void Screen::draw(HDC, int phase) {
+	if (phase != EuroScope::REFRESH_PHASE_BEFORE_TAGS) return;
+
+	find_highlights(GetRadarArea());
+	list_lines();
+
+	for (const auto &highlight : highlights) ConvertCoordFromPositionToPixel(plugin->ac_position[highlight.ac]);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <windows.h>
+
+#include <EuroScopePlugIn.hpp>
+
+// stand-in for EuroScope, so the plugin can run natively: the SDK classes
+// are implemented over this in-memory state, which a driver sets up and
+// changes before calling the plugin's hooks
+namespace host {
+
+namespace EuroScope = EuroScopePlugIn;
+
+// an aircraft as EuroScope knows it, as flight plan and radar target both
+struct Aircraft {
+	std::string callsign;
+	std::uint32_t index;
+
+	// false for a radar target no flight plan is correlated with, which
+	// FlightPlanSelect and the like do not find
+	bool flight_plan = true;
+
+	EuroScope::CPosition position;
+	int gs = 0, altitude = 0;
+	double track = 0;
+
+	std::string origin, destination, departure_rwy, arrival_rwy;
+	char engine_type = 'J', wtc = 'M';
+	double from_origin = 0, to_destination = 0;
+
+	std::string ground_state, scratch_pad;
+	std::array<std::string, 9> annotations;
+
+	// one a minute from now, as EuroScope predicts
+	std::vector<EuroScope::CPosition> predictions;
+};
+
+// a sector file element; runways have both ends, the rest one position
+struct Element {
+	int type;
+	std::string name, airport;
+	std::string runway[2];
+	EuroScope::CPosition position[2];
+	bool active[2][2] = {}; // [end][departure]
+};
+
+struct Message {
+	std::string handler, sender, text;
+};
+
+struct PopupElement {
+	std::string first, second;
+	int function;
+};
+
+// EuroScope keeps its own order, which nothing here depends on; a set keeps
+// adding and removing cheap however long the list gets
+struct FpList {
+	std::string name;
+	int columns = 0;
+	std::unordered_set<std::string> callsigns;
+};
+
+struct World {
+	EuroScope::CPlugIn *plugin = nullptr;
+
+	std::vector<std::unique_ptr<Aircraft>> aircraft;
+	std::unordered_map<std::string, Aircraft *> by_callsign;
+	std::vector<Element> elements;
+	std::vector<std::unique_ptr<FpList>> lists;
+
+	std::string config;
+	std::string asel;
+
+	EuroScope::CPosition controller;
+	int range = 20;
+
+	// the radar area, and the display area it shows
+	RECT radar_area = { 0, 0, 1920, 1080 };
+	EuroScope::CPosition display_sw, display_ne;
+
+	std::vector<std::pair<std::string, int>> tag_items, tag_functions;
+	std::vector<Message> messages;
+	std::vector<PopupElement> popup;
+	std::string popup_edit;
+
+	Aircraft *find(std::string_view);
+	Aircraft &add(std::string_view);
+	void remove(std::string_view);
+	void clear();
+};
+
+World &world();
+
+// handles for an aircraft, as EuroScope would pass them to the hooks; these
+// need the plugin to have been created
+EuroScope::CFlightPlan flight_plan(const Aircraft &);
+EuroScope::CRadarTarget radar_target(const Aircraft &);
+
+}
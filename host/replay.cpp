@@ -0,0 +1,346 @@
+#include <cmath>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <numbers>
+
+#include "replay.hpp"
+
+namespace host {
+
+const char *const HOOK_NAMES[HOOK_COUNT] = {
+	"OnRadarTargetPositionUpdate",
+	"OnFlightPlanFlightPlanDataUpdate",
+	"OnFlightPlanControllerAssignedDataUpdate",
+	"OnFlightPlanDisconnect",
+	"OnNewMetarReceived",
+	"OnAirportRunwayActivityChanged",
+	"OnTimer",
+	"OnFunctionCall",
+	"OnCompileCommand",
+	"OnGetTagItem",
+	"OnRefresh",
+};
+
+const int PREDICTION_MINUTES = 30;
+const int AIRBORNE_SPEED = 50; // kt
+const double EARTH_RADIUS_NM = 3440.065;
+
+void HookTimes::add(std::chrono::steady_clock::duration taken) {
+	using namespace std::chrono;
+
+	calls++;
+	total += taken;
+	max = std::max(max, taken);
+
+	double us = duration<double, std::micro>(taken).count();
+	p50.push(us);
+	p99.push(us);
+}
+
+// where a great circle from a position on a bearing reaches after a distance
+static EuroScope::CPosition travel(const EuroScope::CPosition &from, double bearing, double nm) {
+	const double rad = std::numbers::pi / 180;
+
+	double lat = from.m_Latitude * rad, lon = from.m_Longitude * rad;
+	double d = nm / EARTH_RADIUS_NM, b = bearing * rad;
+
+	double lat2 = std::asin(std::sin(lat) * std::cos(d) + std::cos(lat) * std::sin(d) * std::cos(b));
+	double lon2 = lon + std::atan2(std::sin(b) * std::sin(d) * std::cos(lat), std::cos(d) - std::sin(lat) * std::sin(lat2));
+
+	EuroScope::CPosition posn;
+	posn.m_Latitude = lat2 / rad;
+	posn.m_Longitude = lon2 / rad;
+	return posn;
+}
+
+bool Replay::open(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+
+	return open(std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+}
+
+bool Replay::open(std::vector<char> log) {
+	data = std::move(log);
+	if (!reader.open(data.data(), data.size())) return false;
+
+	pending = reader.next();
+	return true;
+}
+
+void Replay::prelude() {
+	while (pending && reader.type != record::LIVE) {
+		apply(false);
+		pending = reader.next();
+	}
+
+	if (pending) pending = reader.next();
+}
+
+void Replay::attach(EuroScope::CPlugIn *p, EuroScope::CRadarScreen *s) {
+	plugin = p;
+	screen = s;
+}
+
+bool Replay::step() {
+	if (!pending) return false;
+
+	apply(true);
+	records++;
+	peak_aircraft = std::max(peak_aircraft, world().aircraft.size());
+
+	// nobody reads them, and they would pile up over a long session
+	world().messages.clear();
+
+	pending = reader.next();
+	return true;
+}
+
+template<typename F>
+void Replay::call(Hook hook, F f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	times[hook].add(std::chrono::steady_clock::now() - start);
+}
+
+// the aircraft a record is about, brought into the world if it is not yet
+Aircraft *Replay::aircraft(std::uint32_t id) {
+	if (id >= callsigns.size() || callsigns[id].empty()) return nullptr;
+	return &world().add(callsigns[id]);
+}
+
+// applies the current record to the world and, once live, calls the hook it
+// was recorded from
+void Replay::apply(bool live) {
+	auto &w = world();
+
+	switch (reader.type) {
+		case record::CALLSIGN: {
+			auto id = reader.u32();
+			if (id >= callsigns.size()) callsigns.resize(id + 1);
+			callsigns[id] = reader.str();
+
+			break;
+		}
+
+		case record::POSITION: {
+			auto ac = aircraft(reader.u32());
+			if (!ac) break;
+
+			ac->position = reader.position();
+			ac->altitude = reader.i32();
+			ac->gs = reader.u16();
+			ac->track = reader.u16() / 100.0;
+
+			auto origin = airports.find(ac->origin), destination = airports.find(ac->destination);
+			if (origin != airports.end()) ac->from_origin = ac->position.DistanceTo(std::get<1>(*origin));
+			if (destination != airports.end()) ac->to_destination = ac->position.DistanceTo(std::get<1>(*destination));
+
+			// EuroScope predicts along the route; straight ahead is as near
+			// as the log allows
+			ac->predictions.clear();
+			if (ac->gs > AIRBORNE_SPEED) {
+				for (int i = 1; i <= PREDICTION_MINUTES; i++)
+					ac->predictions.push_back(travel(ac->position, ac->track, ac->gs * i / 60.0));
+			}
+
+			if (live) call(HOOK_POSITION, [&] { plugin->OnRadarTargetPositionUpdate(radar_target(*ac)); });
+
+			break;
+		}
+
+		case record::FLIGHT_PLAN: {
+			auto ac = aircraft(reader.u32());
+			if (!ac) break;
+
+			ac->origin = reader.str();
+			ac->destination = reader.str();
+			ac->departure_rwy = reader.str();
+			ac->arrival_rwy = reader.str();
+			ac->engine_type = reader.u8();
+			ac->wtc = reader.u8();
+			ac->ground_state = reader.str();
+
+			if (live) call(HOOK_FLIGHT_PLAN, [&] { plugin->OnFlightPlanFlightPlanDataUpdate(flight_plan(*ac)); });
+
+			break;
+		}
+
+		case record::ASSIGNED: {
+			auto ac = aircraft(reader.u32());
+			if (!ac) break;
+
+			int type = reader.u8();
+			ac->ground_state = reader.str();
+			ac->scratch_pad = reader.str();
+			ac->annotations[3] = reader.str();
+
+			if (live) call(HOOK_ASSIGNED, [&] { plugin->OnFlightPlanControllerAssignedDataUpdate(flight_plan(*ac), type); });
+
+			break;
+		}
+
+		case record::DISCONNECT: {
+			auto ac = aircraft(reader.u32());
+			if (!ac) break;
+
+			if (live) call(HOOK_DISCONNECT, [&] { plugin->OnFlightPlanDisconnect(flight_plan(*ac)); });
+			w.remove(ac->callsign);
+
+			break;
+		}
+
+		case record::METAR: {
+			std::string ad(reader.str()), metar(reader.str());
+			if (live) call(HOOK_METAR, [&] { plugin->OnNewMetarReceived(ad.c_str(), metar.c_str()); });
+
+			break;
+		}
+
+		case record::RUNWAYS: {
+			set_runways();
+			if (live) call(HOOK_RUNWAYS, [&] { plugin->OnAirportRunwayActivityChanged(); });
+
+			break;
+		}
+
+		case record::REFRESH: {
+			int phase = reader.u8();
+			reader.u32();
+			auto tag_items = reader.u32();
+
+			if (!live || !screen) break;
+
+			// the highlight pass runs before the tags; the other phases are
+			// replayed but not timed
+			if (phase == EuroScope::REFRESH_PHASE_BEFORE_TAGS)
+				call(HOOK_REFRESH, [&] { screen->OnRefresh(nullptr, phase); });
+			else
+				screen->OnRefresh(nullptr, phase);
+
+			get_tag_items(tag_items);
+
+			break;
+		}
+
+		case record::VIEW: {
+			w.radar_area.left = reader.i16();
+			w.radar_area.top = reader.i16();
+			w.radar_area.right = reader.i16();
+			w.radar_area.bottom = reader.i16();
+			w.display_sw = reader.position();
+			w.display_ne = reader.position();
+
+			break;
+		}
+
+		case record::TIMER: {
+			int counter = reader.i32();
+			if (live) call(HOOK_TIMER, [&] { plugin->OnTimer(counter); });
+
+			break;
+		}
+
+		case record::FUNCTION: {
+			int code = reader.i32();
+			std::string item(reader.str());
+			auto ac = aircraft(reader.u32());
+
+			w.asel = ac ? ac->callsign : "";
+			if (live) call(HOOK_FUNCTION, [&] { plugin->OnFunctionCall(code, item.c_str(), {}, w.radar_area); });
+
+			break;
+		}
+
+		case record::COMMAND: {
+			std::string cmd(reader.str());
+
+			// replaying into another recording would only confuse matters
+			if (!live || !std::strncmp(cmd.c_str(), ".recordvsmrplus", 15)) break;
+
+			call(HOOK_COMMAND, [&] { plugin->OnCompileCommand(cmd.c_str()); });
+
+			break;
+		}
+
+		case record::ELEMENT: {
+			auto &el = w.elements.emplace_back();
+			el.type = reader.u8();
+			el.name = reader.str();
+			el.airport = reader.str();
+			el.runway[0] = reader.str();
+			el.runway[1] = reader.str();
+			el.position[0] = reader.position();
+			el.position[1] = reader.position();
+
+			if (el.type == EuroScope::SECTOR_ELEMENT_AIRPORT) airports[el.name] = el.position[0];
+
+			break;
+		}
+
+		case record::CONTROLLER: {
+			w.controller = reader.position();
+			w.range = reader.i32();
+
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+void Replay::set_runways() {
+	auto &elements = world().elements;
+
+	for (auto &el : elements) std::memset(el.active, 0, sizeof el.active);
+
+	for (auto count = reader.u16(); count; count--) {
+		auto ad = reader.str(), runway = reader.str();
+		auto flags = reader.u8();
+
+		for (auto &el : elements) {
+			for (int i = 0; i < 2; i++) {
+				bool match = runway.empty()
+					? !i && el.type == EuroScope::SECTOR_ELEMENT_AIRPORT && el.name == ad
+					: el.type == EuroScope::SECTOR_ELEMENT_RUNWAY && el.airport == ad && el.runway[i] == runway;
+				if (!match) continue;
+
+				el.active[i][1] |= flags & 1;
+				el.active[i][0] |= flags >> 1 & 1;
+			}
+		}
+	}
+}
+
+// EuroScope gets each tag item of each tag shown as it draws; the log only
+// says how many it got, so they are spread over the aircraft and items in
+// turn
+void Replay::get_tag_items(std::uint32_t count) {
+	const auto &w = world();
+	size_t pairs = w.aircraft.size() * w.tag_items.size();
+	if (!pairs) return;
+
+	char string[16];
+	int colour;
+	COLORREF rgb;
+	double size;
+
+	for (std::uint32_t i = 0; i < count; i++) {
+		tag_cursor = (tag_cursor + 1) % pairs;
+
+		const auto &ac = *w.aircraft[tag_cursor / w.tag_items.size()];
+		int code = std::get<1>(w.tag_items[tag_cursor % w.tag_items.size()]);
+
+		auto fp = flight_plan(ac);
+		auto rt = radar_target(ac);
+
+		string[0] = 0;
+		call(HOOK_TAG_ITEM, [&] { plugin->OnGetTagItem(fp, rt, code, 0, string, &colour, &rgb, &size); });
+	}
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "host.hpp"
+#include "plugin.hpp"
+#include "recorder.hpp"
+
+namespace host {
+
+// the hooks a log drives, as timed by a replay
+enum Hook {
+	HOOK_POSITION,
+	HOOK_FLIGHT_PLAN,
+	HOOK_ASSIGNED,
+	HOOK_DISCONNECT,
+	HOOK_METAR,
+	HOOK_RUNWAYS,
+	HOOK_TIMER,
+	HOOK_FUNCTION,
+	HOOK_COMMAND,
+	HOOK_TAG_ITEM,
+	HOOK_REFRESH,
+	HOOK_COUNT
+};
+
+extern const char *const HOOK_NAMES[HOOK_COUNT];
+
+// latency of one hook, with streaming estimates of the median and 99th
+// percentile
+struct HookTimes {
+	std::uint64_t calls = 0;
+	std::chrono::steady_clock::duration total {}, max {};
+	P2Quantile p50 { 0.5 }, p99 { 0.99 };
+
+	void add(std::chrono::steady_clock::duration);
+};
+
+// plays a session log into the world and the plugin's hooks. the snapshot
+// the log opens with is set up before the plugin is created, as EuroScope
+// would have it when loading the plugin mid-session; everything after is
+// then stepped through one record at a time
+class Replay {
+private:
+	std::vector<char> data;
+	record::Reader reader;
+	bool pending = false;
+
+	EuroScope::CPlugIn *plugin = nullptr;
+	EuroScope::CRadarScreen *screen = nullptr;
+
+	std::vector<std::string> callsigns;
+	std::unordered_map<std::string, EuroScope::CPosition> airports;
+	size_t tag_cursor = 0;
+
+	Aircraft *aircraft(std::uint32_t);
+	void apply(bool);
+	void set_runways();
+	void get_tag_items(std::uint32_t);
+
+	template<typename F>
+	void call(Hook, F);
+
+public:
+	std::array<HookTimes, HOOK_COUNT> times;
+	std::uint64_t records = 0;
+	size_t peak_aircraft = 0;
+
+	bool open(const std::string &);
+	bool open(std::vector<char>);
+
+	// applies the snapshot, up to the first live record
+	void prelude();
+	void attach(EuroScope::CPlugIn *, EuroScope::CRadarScreen *);
+
+	// time of the next record in ms since the start, or UINT32_MAX at the end
+	std::uint32_t next_time() const { return pending ? reader.time : UINT32_MAX; }
+	bool step();
+};
+
+}
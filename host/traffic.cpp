@@ -0,0 +1,851 @@
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <numbers>
+#include <sstream>
+
+#include "traffic.hpp"
+
+namespace host {
+
+const int RADAR_INTERVAL = 5; // s
+const int METAR_INTERVAL = 1800; // s
+const int TAG_ITEMS_SHOWN = 4;
+const int CONTROLLER_RANGE = 50; // nmi
+
+const double PUSH_SPEED = 3; // kt
+const double TAXI_SPEED = 15; // kt
+const double SLOW_SPEED = 8; // kt
+const double FINAL_SPEED = 140; // kt
+const double ROTATE_SPEED = 150; // kt
+const double CLIMB_SPEED = 180; // kt
+const double ACCELERATION = 5; // kt/s
+const double DECELERATION = 4; // kt/s
+const double CLIMB_RATE = 2500; // ft/min
+const double GLIDE_SLOPE = 318; // ft/nmi
+const double DEPARTED_ALTITUDE = 3000; // ft
+
+const double FINAL_DIST = 8; // nmi
+const double TOUCHDOWN_DIST = 300; // m
+const double STOPPING_DIST = 1300; // m
+const double CLEAR_FINAL_DIST = 3700; // m
+const double SLOW_DIST = 150; // m
+const double QUEUE_JOIN_DIST = 300; // m
+const double QUEUE_SPACING = 60; // m
+const double HOTSPOT_DIST = 30; // m
+const double HOTSPOT_STOP_CHANCE = 0.25;
+
+const unsigned DEPARTURE_INTERVAL = 90; // s
+const unsigned ARRIVAL_INTERVAL = 120; // s
+
+const char *const AIRLINES[] = { "BAW", "EZY", "RYR", "DLH", "AFR", "KLM", "UAE", "VIR", "TOM", "WZZ" };
+const char *const AERODROMES[] = { "LFPG", "EHAM", "EDDF", "LEMD", "LIRF", "EIDW", "KJFK", "OMDB", "LSZH", "EKCH" };
+
+Traffic::Traffic(TrafficOptions opts) : options(std::move(opts)), rng(options.seed) {}
+
+double Traffic::uniform(double a, double b) {
+	return std::uniform_real_distribution<double>(a, b)(rng);
+}
+
+std::uint32_t Traffic::pick(size_t n) {
+	return std::uniform_int_distribution<std::uint32_t>(0, n - 1)(rng);
+}
+
+bool Traffic::load(const std::string &path) {
+	std::ifstream is(path);
+	if (!is) {
+		error = "cannot open " + path;
+		return false;
+	}
+
+	// the lines for the aerodrome, by type, as positions are only projected
+	// once all of them are known
+	std::vector<std::vector<std::string>> lines;
+	std::vector<EuroScope::CPosition> all;
+	std::string line, current;
+
+	ad = options.aerodrome;
+
+	while (std::getline(is, line)) {
+		if (line.empty() || line[0] == ';') continue;
+
+		std::istringstream buf(line);
+		std::vector<std::string> parts(std::istream_iterator<std::string>(buf), {});
+		if (parts.empty() || parts[0].size() != 1) continue;
+
+		if (parts[0][0] == 'A' && parts.size() == 2) {
+			current = parts[1];
+			if (ad.empty()) ad = current;
+			continue;
+		}
+
+		if (current.empty() || current != ad) continue;
+		if (std::string("CILTW").find(parts[0][0]) == std::string::npos) continue;
+
+		lines.push_back(std::move(parts));
+	}
+
+	if (ad.empty()) {
+		error = "no aerodrome in " + path;
+		return false;
+	}
+
+	// each line's positions, from the field at which they start
+	auto positions = [](const std::vector<std::string> &parts, size_t first) {
+		std::vector<EuroScope::CPosition> posns;
+		for (size_t i = first; i + 1 < parts.size(); i += 2) {
+			EuroScope::CPosition pos;
+			if (!pos.LoadFromStrings(parts[i + 1].c_str(), parts[i].c_str())) return std::vector<EuroScope::CPosition>();
+			posns.push_back(pos);
+		}
+
+		return posns;
+	};
+
+	auto first_position = [](char type) -> size_t {
+		switch (type) {
+			case 'C': return 1;
+			case 'I': return 2;
+			case 'L': return 2;
+			case 'T': return 2;
+			default: return 3;
+		}
+	};
+
+	for (const auto &parts : lines) {
+		if (parts[0][0] != 'L' && parts[0][0] != 'T') continue;
+
+		auto posns = positions(parts, first_position(parts[0][0]));
+		all.insert(all.end(), posns.begin(), posns.end());
+	}
+
+	if (all.empty()) {
+		error = "no stands or taxiways for " + ad;
+		return false;
+	}
+
+	for (const auto &pos : all) {
+		reference.m_Latitude += pos.m_Latitude / all.size();
+		reference.m_Longitude += pos.m_Longitude / all.size();
+	}
+
+	frame = LocalFrame(reference);
+
+	// centrelines first, so holding points and stands can be joined to them
+	for (char type : { 'T', 'W', 'L', 'C', 'I' }) {
+		std::vector<std::uint8_t> blocked;
+		std::vector<ClosedArea> closed;
+
+		for (const auto &parts : lines) {
+			if (parts[0][0] != type) continue;
+
+			auto posns = positions(parts, first_position(type));
+			if (posns.empty()) continue;
+
+			std::vector<Vec2> points;
+			for (const auto &pos : posns) points.push_back(frame.project(pos));
+
+			switch (type) {
+				case 'T':
+					if (points.size() >= 2) graph.add(parts[1], points, posns);
+					break;
+
+				case 'W':
+					holds.push_back({ parts[1], graph.link(points[0], posns[0]), {} });
+					break;
+
+				case 'L':
+					if (!graph.nodes.empty()) stands.push_back({ parts[1], points[0], nearest_node(points[0]) });
+					break;
+
+				case 'C':
+					if (points.size() >= 3) closed.emplace_back(posns, 0, frame);
+					break;
+
+				case 'I':
+					hotspots.push_back(points[0]);
+					break;
+			}
+		}
+
+		// as the plugin blocks them, by their midpoints
+		if (type == 'C' && !closed.empty()) {
+			blocked.resize(graph.edges.size());
+
+			for (std::uint32_t e = 0; e < graph.edges.size(); e++) {
+				const auto &a = graph.nodes[graph.edges[e].a], &b = graph.nodes[graph.edges[e].b];
+				Vec2 mid = { (a.x + b.x) / 2, (a.y + b.y) / 2 };
+
+				for (const auto &area : closed) blocked[e] |= area.contains(mid);
+			}
+
+			graph.block(std::move(blocked));
+		}
+	}
+
+	if (graph.edges.empty()) {
+		error = "no taxiways for " + ad;
+		return false;
+	}
+
+	if (holds.empty()) {
+		error = "no holding points for " + ad;
+		return false;
+	}
+
+	if (!options.runways.empty()) {
+		in_use = options.in_use.empty() ? options.runways[0].name[0] : options.in_use;
+
+		for (const auto &rwy : options.runways) {
+			for (int i = 0; i < 2; i++) {
+				if (rwy.name[i] != in_use) continue;
+
+				runway = &rwy;
+				start = frame.project(rwy.threshold[i]);
+
+				auto end = frame.project(rwy.threshold[1 - i]);
+				length = std::hypot(end.x - start.x, end.y - start.y);
+				dir = { (end.x - start.x) / length, (end.y - start.y) / length };
+			}
+		}
+
+		if (!runway) {
+			error = "runway " + in_use + " is not given";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+EuroScope::CPosition Traffic::position(Vec2 p) const {
+	return frame.unproject(p);
+}
+
+std::uint32_t Traffic::nearest_node(Vec2 p) const {
+	std::uint32_t nearest = UINT32_MAX;
+	float nearest_dist = INFINITY;
+
+	for (std::uint32_t n = 0; n < graph.nodes.size(); n++) {
+		float dist = std::hypot(graph.nodes[n].x - p.x, graph.nodes[n].y - p.y);
+		if (dist < nearest_dist) {
+			nearest = n;
+			nearest_dist = dist;
+		}
+	}
+
+	return nearest;
+}
+
+// points along the open taxiways from one node to another, then to a final
+// point; straight there if the closures leave no way through
+void Traffic::route(Flight &f, std::uint32_t from, std::uint32_t to, Vec2 last) {
+	f.path = { graph.nodes[from] };
+	f.edges = { UINT32_MAX };
+
+	if (auto edges = graph.route(from, to)) {
+		auto n = from;
+		for (auto e : *edges) {
+			n = graph.other(e, n);
+			f.path.push_back(graph.nodes[n]);
+			f.edges.push_back(e);
+		}
+	}
+
+	f.path.push_back(graph.nodes[to]);
+	f.path.push_back(last);
+	f.edges.resize(f.path.size(), UINT32_MAX);
+
+	f.next = 0;
+}
+
+std::uint32_t Traffic::free_stand() {
+	std::vector<std::uint32_t> free;
+	for (std::uint32_t i = 0; i < stands.size(); i++)
+		if (stands[i].occupant == UINT32_MAX) free.push_back(i);
+
+	return free.empty() ? UINT32_MAX : free[pick(free.size())];
+}
+
+bool Traffic::runway_free() const {
+	for (const auto &f : flights) {
+		switch (f.phase) {
+			case LINE_UP:
+			case LANDING:
+				return false;
+
+			case ROLL:
+				if (f.altitude < 500) return false;
+				break;
+
+			case FINAL:
+				if (std::hypot(f.p.x - start.x, f.p.y - start.y) < CLEAR_FINAL_DIST) return false;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return true;
+}
+
+// a departure at a stand, or parked somewhere on the taxiways if there is no
+// stand free, until it starts up after a while
+void Traffic::spawn_departure(std::uint32_t stand, double dwell) {
+	std::uint32_t id = flights.size();
+	auto &f = flights.emplace_back();
+
+	f.callsign = AIRLINES[pick(std::size(AIRLINES))] + std::to_string(100 + id);
+	f.other_end = AERODROMES[pick(std::size(AERODROMES))];
+	f.departure = true;
+	f.phase = AT_STAND;
+	f.wait = dwell;
+	f.track = uniform(0, 360);
+	f.wtc = uniform(0, 1) < 0.15 ? 'H' : 'M';
+
+	if (stand != UINT32_MAX) {
+		f.stand = stand;
+		f.p = stands[stand].p;
+		stands[stand].occupant = id;
+	} else {
+		f.p = graph.nodes[pick(graph.nodes.size())];
+	}
+
+	spawned++;
+
+	emit_callsign(id);
+	emit_flight_plan(id);
+	emit_assigned(id);
+	emit_position(id);
+}
+
+// an arrival on final, or just off the runway if there is none
+void Traffic::spawn_arrival() {
+	std::uint32_t id = flights.size();
+	auto &f = flights.emplace_back();
+
+	f.callsign = AIRLINES[pick(std::size(AIRLINES))] + std::to_string(100 + id);
+	f.other_end = AERODROMES[pick(std::size(AERODROMES))];
+	f.departure = false;
+	f.wtc = uniform(0, 1) < 0.15 ? 'H' : 'M';
+
+	spawned++;
+
+	if (runway) {
+		double dist = FINAL_DIST * METRES_PER_NM;
+
+		f.phase = FINAL;
+		f.p = { (float) (start.x - dir.x * dist), (float) (start.y - dir.y * dist) };
+		f.path = { { (float) (start.x + dir.x * TOUCHDOWN_DIST), (float) (start.y + dir.y * TOUCHDOWN_DIST) } };
+		f.gs = FINAL_SPEED;
+		f.altitude = FINAL_DIST * GLIDE_SLOPE;
+		f.track = std::fmod(std::atan2(dir.x, dir.y) * 180 / std::numbers::pi + 360, 360);
+
+		emit_callsign(id);
+		emit_flight_plan(id);
+		emit_position(id);
+	} else {
+		f.hold = pick(holds.size());
+		f.p = graph.nodes[holds[f.hold].node];
+
+		emit_callsign(id);
+		emit_flight_plan(id);
+		emit_position(id);
+
+		vacated(id);
+	}
+}
+
+// from wherever it pushed back to, to one of the holding points for the
+// runway in use
+void Traffic::taxi_out(std::uint32_t id) {
+	auto &f = flights[id];
+
+	std::vector<std::uint32_t> candidates;
+	for (std::uint32_t i = 0; i < holds.size(); i++)
+		if (!runway || holds[i].runway == in_use) candidates.push_back(i);
+
+	if (candidates.empty())
+		for (std::uint32_t i = 0; i < holds.size(); i++) candidates.push_back(i);
+
+	f.hold = candidates[pick(candidates.size())];
+
+	auto hold = holds[f.hold].node;
+	route(f, nearest_node(f.p), hold, graph.nodes[hold]);
+	f.phase = TAXI;
+	f.wait = uniform(10, 40);
+
+	set_ground_state(id, "TAXI");
+}
+
+// touches down and rolls out to the first exit it can make, by the holding
+// point for the runway beyond where it stops
+void Traffic::land(std::uint32_t id) {
+	auto &f = flights[id];
+
+	std::uint32_t exit = UINT32_MAX;
+	float exit_along = INFINITY, last_along = -INFINITY;
+
+	for (std::uint32_t i = 0; i < holds.size(); i++) {
+		if (holds[i].runway != runway->name[0] && holds[i].runway != runway->name[1]) continue;
+
+		const auto &n = graph.nodes[holds[i].node];
+		float along = (n.x - start.x) * dir.x + (n.y - start.y) * dir.y;
+		if (along > length) continue;
+
+		if (along >= TOUCHDOWN_DIST + STOPPING_DIST ? along < exit_along : exit_along == INFINITY && along > last_along) {
+			exit = i;
+			if (along >= TOUCHDOWN_DIST + STOPPING_DIST) exit_along = along;
+			else last_along = along;
+		}
+	}
+
+	if (exit == UINT32_MAX) exit = pick(holds.size());
+
+	const auto &n = graph.nodes[holds[exit].node];
+	float along = std::clamp((n.x - start.x) * dir.x + (n.y - start.y) * dir.y, (float) TOUCHDOWN_DIST, length);
+
+	f.hold = exit;
+	f.phase = LANDING;
+	f.altitude = 0;
+	f.path = { { start.x + dir.x * along, start.y + dir.y * along }, n };
+	f.next = 0;
+}
+
+// off the runway, so given a stand and a route to it
+void Traffic::vacated(std::uint32_t id) {
+	auto &f = flights[id];
+	auto from = nearest_node(f.p);
+
+	f.stand = free_stand();
+	if (f.stand != UINT32_MAX) {
+		auto &stand = stands[f.stand];
+		stand.occupant = id;
+		route(f, from, stand.node, stand.p);
+	} else {
+		auto to = pick(graph.nodes.size());
+		route(f, from, to, graph.nodes[to]);
+	}
+
+	f.phase = TAXI;
+
+	set_ground_state(id, "TAXI");
+}
+
+// moves along the path at a speed for a second, at most some distance;
+// true once at the end
+bool Traffic::advance(Flight &f, double kt, double most) {
+	double left = std::min(kt * KNOT, most), moved = 0;
+
+	while (left > 0 && f.next < f.path.size()) {
+		auto target = f.path[f.next];
+		double dx = target.x - f.p.x, dy = target.y - f.p.y, d = std::hypot(dx, dy);
+
+		if (d > 0.01) f.track = std::fmod(std::atan2(dx, dy) * 180 / std::numbers::pi + 360, 360);
+
+		if (d <= left) {
+			f.p = target;
+			f.next++;
+			left -= d;
+			moved += d;
+		} else {
+			f.p.x += dx / d * left;
+			f.p.y += dy / d * left;
+			moved += left;
+			left = 0;
+		}
+	}
+
+	f.gs = moved / KNOT;
+
+	return f.next >= f.path.size();
+}
+
+double Traffic::remaining(const Flight &f) const {
+	double total = 0;
+	Vec2 p = f.p;
+
+	for (size_t i = f.next; i < f.path.size(); i++) {
+		total += std::hypot(f.path[i].x - p.x, f.path[i].y - p.y);
+		p = f.path[i];
+	}
+
+	return total;
+}
+
+// one second of a flight
+void Traffic::update(std::uint32_t id) {
+	auto &f = flights[id];
+
+	switch (f.phase) {
+		case AT_STAND: {
+			f.wait--;
+			if (f.wait <= 60 && f.ground_state.empty()) set_ground_state(id, "STUP");
+			if (f.wait > 0) break;
+
+			if (f.stand == UINT32_MAX) {
+				taxi_out(id);
+				break;
+			}
+
+			auto &stand = stands[f.stand];
+			stand.occupant = UINT32_MAX;
+
+			f.phase = PUSHBACK;
+			f.path = { graph.nodes[stand.node] };
+			f.next = 0;
+
+			set_ground_state(id, "PUSH");
+
+			break;
+		}
+
+		case PUSHBACK:
+			if (advance(f, PUSH_SPEED)) taxi_out(id);
+			break;
+
+		case TAXI: {
+			if (f.wait > 0) {
+				f.wait--;
+				f.gs = 0;
+				break;
+			}
+
+			// giving way at hotspots, now and then
+			bool stopped = false;
+			for (std::uint32_t h = 0; h < hotspots.size() && !stopped; h++) {
+				if (std::hypot(hotspots[h].x - f.p.x, hotspots[h].y - f.p.y) > HOTSPOT_DIST) continue;
+				if (std::find(f.passed.begin(), f.passed.end(), h) != f.passed.end()) continue;
+
+				f.passed.push_back(h);
+				if (uniform(0, 1) < HOTSPOT_STOP_CHANCE) {
+					f.wait = uniform(10, 40);
+					f.gs = 0;
+					stopped = true;
+				}
+			}
+
+			if (stopped) break;
+
+			double left = remaining(f);
+			double speed = left < SLOW_DIST ? SLOW_SPEED : TAXI_SPEED;
+
+			if (!f.departure) {
+				if (advance(f, speed)) {
+					f.phase = PARKED;
+					f.gs = 0;
+					f.wait = uniform(60, 300);
+					set_ground_state(id, "PARK");
+				}
+
+				break;
+			}
+
+			// departures queue for the holding point once close to it, each
+			// stopping short of the one ahead
+			auto &queue = holds[f.hold].queue;
+			auto it = std::find(queue.begin(), queue.end(), id);
+			if (it == queue.end() && left < QUEUE_JOIN_DIST) it = queue.insert(queue.end(), id);
+
+			double stop = it == queue.end() ? 0 : (it - queue.begin()) * QUEUE_SPACING;
+			if (left - stop > 0.5) advance(f, speed, left - stop);
+			else f.gs = 0;
+
+			if (it == queue.begin() && remaining(f) <= 0.5) f.phase = HOLDING;
+
+			break;
+		}
+
+		case HOLDING: {
+			f.gs = 0;
+			if (now < next_departure || (runway && !runway_free())) break;
+
+			auto &queue = holds[f.hold].queue;
+			queue.erase(std::find(queue.begin(), queue.end(), id));
+			next_departure = now + DEPARTURE_INTERVAL;
+
+			if (!runway) {
+				disconnect(id);
+				break;
+			}
+
+			float along = std::clamp((f.p.x - start.x) * dir.x + (f.p.y - start.y) * dir.y, 0.0f, length);
+
+			f.phase = LINE_UP;
+			f.path = { { start.x + dir.x * along, start.y + dir.y * along } };
+			f.next = 0;
+
+			set_ground_state(id, "DEPA");
+
+			break;
+		}
+
+		case LINE_UP:
+			if (advance(f, SLOW_SPEED)) {
+				double beyond = length + FINAL_DIST * METRES_PER_NM;
+
+				f.phase = ROLL;
+				f.path = { { (float) (start.x + dir.x * beyond), (float) (start.y + dir.y * beyond) } };
+				f.next = 0;
+			}
+
+			break;
+
+		case ROLL: {
+			double speed = std::min(f.gs + ACCELERATION, CLIMB_SPEED);
+			bool done = advance(f, speed);
+
+			if (f.gs >= ROTATE_SPEED) f.altitude += CLIMB_RATE / 60;
+			if (done || f.altitude >= DEPARTED_ALTITUDE) disconnect(id);
+
+			break;
+		}
+
+		case FINAL: {
+			bool done = advance(f, FINAL_SPEED);
+			f.altitude = std::hypot(f.p.x - start.x, f.p.y - start.y) / METRES_PER_NM * GLIDE_SLOPE;
+
+			if (done) land(id);
+
+			break;
+		}
+
+		case LANDING:
+		case VACATE: {
+			double speed = std::max(f.gs - DECELERATION, TAXI_SPEED);
+			if (advance(f, speed)) vacated(id);
+			else if (f.next > 0) f.phase = VACATE;
+
+			break;
+		}
+
+		case PARKED:
+			f.wait--;
+			f.gs = 0;
+			if (f.wait <= 0) disconnect(id);
+
+			break;
+
+		case GONE:
+			break;
+	}
+}
+
+void Traffic::emit_prelude() {
+	log.begin(record::CONTROLLER, 0);
+	log.position(reference);
+	log.i32(CONTROLLER_RANGE);
+	log.end();
+
+	log.begin(record::ELEMENT, 0);
+	log.u8(EuroScope::SECTOR_ELEMENT_AIRPORT);
+	log.str(ad);
+	log.str("");
+	log.str("");
+	log.str("");
+	log.position(reference);
+	log.position(reference);
+	log.end();
+
+	for (const auto &rwy : options.runways) {
+		log.begin(record::ELEMENT, 0);
+		log.u8(EuroScope::SECTOR_ELEMENT_RUNWAY);
+		log.str(rwy.name[0] + " - " + rwy.name[1]);
+		log.str(ad);
+		log.str(rwy.name[0]);
+		log.str(rwy.name[1]);
+		log.position(rwy.threshold[0]);
+		log.position(rwy.threshold[1]);
+		log.end();
+	}
+
+	log.begin(record::RUNWAYS, 0);
+	log.u16(runway ? 2 : 1);
+	log.str(ad);
+	log.str("");
+	log.u8(3);
+
+	if (runway) {
+		log.str(ad);
+		log.str(in_use);
+		log.u8(3);
+	}
+
+	log.end();
+}
+
+void Traffic::emit_callsign(std::uint32_t id) {
+	log.begin(record::CALLSIGN, now * 1000);
+	log.u32(id);
+	log.str(flights[id].callsign);
+	log.end();
+}
+
+void Traffic::emit_flight_plan(std::uint32_t id) {
+	const auto &f = flights[id];
+
+	log.begin(record::FLIGHT_PLAN, now * 1000);
+	log.u32(id);
+	log.str(f.departure ? ad : f.other_end);
+	log.str(f.departure ? f.other_end : ad);
+	log.str(f.departure ? in_use : "");
+	log.str(f.departure ? "" : in_use);
+	log.u8('J');
+	log.u8(f.wtc);
+	log.str(f.ground_state);
+	log.end();
+}
+
+void Traffic::emit_assigned(std::uint32_t id) {
+	const auto &f = flights[id];
+
+	log.begin(record::ASSIGNED, now * 1000);
+	log.u32(id);
+	log.u8(EuroScope::CTR_DATA_TYPE_GROUND_STATE);
+	log.str(f.ground_state);
+	log.str("");
+	log.str(f.stand != UINT32_MAX ? stands[f.stand].name : "");
+	log.end();
+}
+
+void Traffic::emit_position(std::uint32_t id) {
+	const auto &f = flights[id];
+
+	// radar noise around the true position, drawn only when asked for so
+	// the same seed gives the same log without
+	Vec2 p = f.p;
+	if (options.noise > 0) {
+		std::normal_distribution<double> noise(0, options.noise);
+		p.x += noise(rng);
+		p.y += noise(rng);
+	}
+
+	log.begin(record::POSITION, now * 1000);
+	log.u32(id);
+	log.position(position(p));
+	log.i32((std::int32_t) std::lround(f.altitude));
+	log.u16((std::uint16_t) std::lround(f.gs));
+	log.u16((std::uint16_t) (std::lround(f.track * 100) % 36000));
+	log.end();
+	if (!options.known || f.phase != TAXI || f.next >= f.edges.size()) return;
+
+	auto e = f.edges[f.next];
+	auto t = e == UINT32_MAX ? UINT32_MAX : graph.edges[e].taxiway;
+	if (t != UINT32_MAX) known.push_back({ now * 1000, f.callsign, graph.taxiways[t] });
+}
+
+void Traffic::emit_metar() {
+	char metar[64];
+	std::snprintf(
+		metar, sizeof metar, "%s 01%02u%02uZ 24008KT 9999 SCT030 15/09 Q%04d",
+		ad.c_str(), now / 3600 % 24, now / 60 % 60, qnh
+	);
+
+	log.begin(record::METAR, now * 1000);
+	log.str(ad);
+	log.str(metar);
+	log.end();
+}
+
+void Traffic::set_ground_state(std::uint32_t id, const char *state) {
+	flights[id].ground_state = state;
+	emit_assigned(id);
+}
+
+void Traffic::disconnect(std::uint32_t id) {
+	auto &f = flights[id];
+
+	if (f.stand != UINT32_MAX && stands[f.stand].occupant == id) stands[f.stand].occupant = UINT32_MAX;
+	if (f.hold != UINT32_MAX) std::erase(holds[f.hold].queue, id);
+
+	f.phase = GONE;
+
+	log.begin(record::DISCONNECT, now * 1000);
+	log.u32(id);
+	log.end();
+}
+
+std::vector<char> Traffic::generate() {
+	log.clear();
+	known.clear();
+	log.header(0);
+
+	emit_prelude();
+
+	// the aircraft on the ground when the plugin loads, at stands or parked
+	// wherever there is room, leaving over the first half hour
+	for (unsigned i = 0; i < options.aircraft; i++)
+		spawn_departure(free_stand(), uniform(0, 1800));
+
+	log.begin(record::LIVE, 0);
+	log.end();
+
+	// the radar area shows all of the taxiways
+	float x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY;
+	for (const auto &n : graph.nodes) {
+		x0 = std::min(x0, n.x);
+		y0 = std::min(y0, n.y);
+		x1 = std::max(x1, n.x);
+		y1 = std::max(y1, n.y);
+	}
+
+	log.begin(record::VIEW, 0);
+	log.i16(0);
+	log.i16(0);
+	log.i16(1920);
+	log.i16(1080);
+	log.position(position({ x0, y0 }));
+	log.position(position({ x1, y1 }));
+	log.end();
+
+	emit_metar();
+
+	for (now = 0; now < options.minutes * 60; now++) {
+		for (std::uint32_t id = 0; id < flights.size(); id++)
+			if (flights[id].phase != GONE) update(id);
+
+		auto active = (unsigned) std::count_if(flights.begin(), flights.end(), [](const Flight &f) { return f.phase != GONE; });
+
+		if (active < options.aircraft && now >= next_arrival) {
+			spawn_arrival();
+			next_arrival = now + ARRIVAL_INTERVAL + pick(60);
+			active++;
+		}
+
+		if (active < options.aircraft) {
+			auto stand = free_stand();
+			if (stand != UINT32_MAX) {
+				spawn_departure(stand, uniform(120, 1200));
+				active++;
+			}
+		}
+
+		peak = std::max<std::uint64_t>(peak, active);
+
+		for (std::uint32_t id = 0; id < flights.size(); id++)
+			if (flights[id].phase != GONE && (now + id) % RADAR_INTERVAL == 0) emit_position(id);
+
+		log.begin(record::TIMER, now * 1000);
+		log.i32(now);
+		log.end();
+
+		log.begin(record::REFRESH, now * 1000);
+		log.u8(EuroScope::REFRESH_PHASE_BEFORE_TAGS);
+		log.u32(0);
+		log.u32(active * TAG_ITEMS_SHOWN);
+		log.end();
+
+		if (now && now % METAR_INTERVAL == 0) {
+			qnh += (int) pick(3) - 1;
+			emit_metar();
+		}
+	}
+
+	return log.data();
+}
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "plugin.hpp"
+#include "recorder.hpp"
+
+namespace host {
+
+struct TrafficRunway {
+	std::string name[2];
+	EuroScope::CPosition threshold[2];
+};
+
+struct TrafficOptions {
+	std::string aerodrome; // the first in the configuration if empty
+	std::uint32_t seed = 1;
+	unsigned aircraft = 100; // on the ground or landing at once
+	unsigned minutes = 60;
+
+	// runways are in the sector file rather than the configuration; with
+	// none, departures leave from the holding points and arrivals appear at
+	// them
+	std::vector<TrafficRunway> runways;
+	std::string in_use; // the end of the first runway if empty
+	double noise = 0; // m, standard deviation of each logged position
+
+	// keeps the taxiway each taxiing position was generated on, to check
+	// the plugin's map matching against
+	bool known = false;
+};
+
+// a position logged while taxiing, with the taxiway it is on
+struct KnownPosition {
+	std::uint32_t time; // ms
+	std::string callsign, taxiway;
+};
+
+// generates surface traffic at an aerodrome as a session log, from the
+// stands, taxiways, holding points, hotspots and closures in the plugin's
+// configuration. departures start up, push back, taxi to a holding point
+// and queue there, then line up and take off; arrivals land, vacate and
+// taxi to a free stand. the same options and seed give the same log
+class Traffic {
+private:
+	enum Phase {
+		AT_STAND,
+		PUSHBACK,
+		TAXI,
+		HOLDING,
+		LINE_UP,
+		ROLL,
+		FINAL,
+		LANDING,
+		VACATE,
+		PARKED,
+		GONE
+	};
+
+	struct Stand {
+		std::string name;
+		Vec2 p;
+		std::uint32_t node, occupant = UINT32_MAX;
+	};
+
+	struct Hold {
+		std::string runway;
+		std::uint32_t node;
+		std::deque<std::uint32_t> queue;
+	};
+
+	struct Flight {
+		std::string callsign, other_end, ground_state;
+		bool departure;
+		Phase phase;
+
+		Vec2 p;
+		double altitude = 0, gs = 0, track = 0; // ft, kt, deg
+		std::vector<Vec2> path;
+		std::vector<std::uint32_t> edges; // along which each point of a route is reached
+		size_t next = 0;
+
+		double wait = 0; // s
+		std::uint32_t stand = UINT32_MAX, hold = UINT32_MAX;
+		std::vector<std::uint32_t> passed;
+		char wtc;
+	};
+
+	TrafficOptions options;
+	std::mt19937 rng;
+
+	std::string ad;
+	EuroScope::CPosition reference;
+	LocalFrame frame;
+	TaxiGraph graph;
+	std::vector<Stand> stands;
+	std::vector<Hold> holds;
+	std::vector<Vec2> hotspots;
+
+	// the runway in use, from the threshold landed on and departed from
+	const TrafficRunway *runway = nullptr;
+	std::string in_use;
+	Vec2 start, dir;
+	float length;
+
+	std::vector<Flight> flights;
+	record::Writer log;
+	std::uint32_t now = 0; // s
+	std::uint32_t next_departure = 0, next_arrival = 0;
+	int qnh = 1013;
+
+	double uniform(double, double);
+	std::uint32_t pick(size_t);
+
+	EuroScope::CPosition position(Vec2) const;
+	std::uint32_t nearest_node(Vec2) const;
+	void route(Flight &, std::uint32_t, std::uint32_t, Vec2);
+	std::uint32_t free_stand();
+	bool runway_free() const;
+
+	void spawn_departure(std::uint32_t, double);
+	void spawn_arrival();
+	void taxi_out(std::uint32_t);
+	void land(std::uint32_t);
+	void vacated(std::uint32_t);
+	void update(std::uint32_t);
+	bool advance(Flight &, double, double = INFINITY);
+	double remaining(const Flight &) const;
+
+	void emit_prelude();
+	void emit_callsign(std::uint32_t);
+	void emit_flight_plan(std::uint32_t);
+	void emit_assigned(std::uint32_t);
+	void emit_position(std::uint32_t);
+	void emit_metar();
+	void set_ground_state(std::uint32_t, const char *);
+	void disconnect(std::uint32_t);
+
+public:
+	std::string error;
+	std::uint64_t spawned = 0, peak = 0;
+	std::vector<KnownPosition> known;
+
+	explicit Traffic(TrafficOptions);
+
+	// reads the configuration; false, with the error set, if it is unusable
+	bool load(const std::string &);
+
+	// the whole log, from a snapshot with the aircraft already on the ground
+	std::vector<char> generate();
+};
+
+}
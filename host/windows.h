@@ -0,0 +1,44 @@
+#pragma once
+
+// the little of the Windows API that the plugin and the EuroScope SDK header
+// use, for building natively against the stand-in host
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define __declspec(x)
+#define __stdcall
+#define WINAPI
+
+typedef int BOOL;
+typedef unsigned long DWORD;
+typedef unsigned long COLORREF;
+typedef const char *LPCSTR;
+typedef const char *LPCTSTR;
+typedef wchar_t WCHAR;
+
+typedef void *HDC;
+typedef void *HWND;
+typedef void *HMODULE;
+
+struct POINT {
+	long x, y;
+};
+
+struct RECT {
+	long left, top, right, bottom;
+};
+
+#define RGB(r, g, b) ((COLORREF) ((std::uint8_t) (r) | (std::uint8_t) (g) << 8 | (std::uint32_t) (std::uint8_t) (b) << 16))
+
+// copies at most count characters and always terminates, as the CRT does
+inline int strncpy_s(char *dest, std::size_t size, const char *src, std::size_t count) {
+	std::size_t n = strnlen(src, count);
+	if (n >= size) n = size - 1;
+
+	std::memcpy(dest, src, n);
+	dest[n] = 0;
+
+	return 0;
+}
@@ -0,0 +1,366 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+
+#include "kernels.hpp"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__clang__) || defined(__GNUC__)
+#define TARGET(isa) __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+
+namespace kernels {
+
+// the vector versions do the same operations in the same order as these, so
+// they agree bit for bit as long as nothing is contracted into an fma
+
+static std::size_t count_near_scalar(std::size_t i, const Vec2 *points, std::size_t n, Vec2 start, Vec2 dir, float length, float radius) {
+	std::size_t count = 0;
+
+	for (; i < n; i++) {
+		float x = points[i].x - start.x, y = points[i].y - start.y;
+		float along = std::min(std::max(x * dir.x + y * dir.y, 0.0f), length);
+		float dx = x - along * dir.x, dy = y - along * dir.y;
+
+		count += dx * dx + dy * dy <= radius * radius;
+	}
+
+	return count;
+}
+
+static void in_polygon_scalar(std::size_t i, const Vec2 *points, std::size_t n, const Vec2 *poly, std::size_t m, std::uint8_t *inside) {
+	for (; i < n; i++) {
+		float x = points[i].x, y = points[i].y;
+		bool in = false;
+
+		for (std::size_t j = 0; j < m; j++) {
+			const auto &a = poly[j], &b = poly[j + 1 < m ? j + 1 : 0];
+
+			if ((a.y > y) == (b.y > y)) continue;
+
+			float t = (y - a.y) / (b.y - a.y);
+			if (x < a.x + t * (b.x - a.x)) in = !in;
+		}
+
+		inside[i] = in;
+	}
+}
+
+static void in_rect_scalar(std::size_t i, const Vec2 *points, std::size_t n, Vec2 centre, Vec2 axis, float half_length, float half_width, std::uint8_t *inside) {
+	for (; i < n; i++) {
+		float x = points[i].x - centre.x, y = points[i].y - centre.y;
+		float along = x * axis.x + y * axis.y;
+		float across = y * axis.x - x * axis.y;
+
+		inside[i] = std::abs(along) <= half_length && std::abs(across) <= half_width;
+	}
+}
+
+static std::size_t count_near_0(const Vec2 *points, std::size_t n, Vec2 start, Vec2 dir, float length, float radius) {
+	return count_near_scalar(0, points, n, start, dir, length, radius);
+}
+
+static void in_polygon_0(const Vec2 *points, std::size_t n, const Vec2 *poly, std::size_t m, std::uint8_t *inside) {
+	in_polygon_scalar(0, points, n, poly, m, inside);
+}
+
+static void in_rect_0(const Vec2 *points, std::size_t n, Vec2 centre, Vec2 axis, float half_length, float half_width, std::uint8_t *inside) {
+	in_rect_scalar(0, points, n, centre, axis, half_length, half_width, inside);
+}
+
+#ifdef KERNELS_X86
+
+// points are stored as x, y pairs; each load takes two pairs and splits them
+TARGET("sse2")
+static inline void load_sse2(const Vec2 *points, __m128 &x, __m128 &y) {
+	__m128 a = _mm_loadu_ps(&points[0].x), b = _mm_loadu_ps(&points[2].x);
+	x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+TARGET("sse2")
+static inline void store_mask(std::uint8_t *inside, int bits, int lanes) {
+	for (int j = 0; j < lanes; j++) inside[j] = bits >> j & 1;
+}
+
+TARGET("sse2")
+static std::size_t count_near_1(const Vec2 *points, std::size_t n, Vec2 start, Vec2 dir, float length, float radius) {
+	__m128 sx = _mm_set1_ps(start.x), sy = _mm_set1_ps(start.y);
+	__m128 ux = _mm_set1_ps(dir.x), uy = _mm_set1_ps(dir.y);
+	__m128 zero = _mm_setzero_ps(), len = _mm_set1_ps(length), r2 = _mm_set1_ps(radius * radius);
+
+	std::size_t i = 0, count = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128 x, y;
+		load_sse2(points + i, x, y);
+		x = _mm_sub_ps(x, sx);
+		y = _mm_sub_ps(y, sy);
+
+		__m128 along = _mm_add_ps(_mm_mul_ps(x, ux), _mm_mul_ps(y, uy));
+		along = _mm_min_ps(_mm_max_ps(along, zero), len);
+
+		__m128 dx = _mm_sub_ps(x, _mm_mul_ps(along, ux));
+		__m128 dy = _mm_sub_ps(y, _mm_mul_ps(along, uy));
+		__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+		count += std::popcount((unsigned) _mm_movemask_ps(_mm_cmple_ps(d2, r2)));
+	}
+
+	return count + count_near_scalar(i, points, n, start, dir, length, radius);
+}
+
+TARGET("sse2")
+static void in_polygon_1(const Vec2 *points, std::size_t n, const Vec2 *poly, std::size_t m, std::uint8_t *inside) {
+	std::size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128 x, y, in = _mm_setzero_ps();
+		load_sse2(points + i, x, y);
+
+		for (std::size_t j = 0; j < m; j++) {
+			const auto &a = poly[j], &b = poly[j + 1 < m ? j + 1 : 0];
+			__m128 ax = _mm_set1_ps(a.x), ay = _mm_set1_ps(a.y);
+
+			__m128 straddle = _mm_xor_ps(_mm_cmpgt_ps(ay, y), _mm_cmpgt_ps(_mm_set1_ps(b.y), y));
+			if (!_mm_movemask_ps(straddle)) continue;
+
+			__m128 t = _mm_div_ps(_mm_sub_ps(y, ay), _mm_set1_ps(b.y - a.y));
+			__m128 cross = _mm_add_ps(ax, _mm_mul_ps(t, _mm_set1_ps(b.x - a.x)));
+
+			in = _mm_xor_ps(in, _mm_and_ps(straddle, _mm_cmplt_ps(x, cross)));
+		}
+
+		store_mask(inside + i, _mm_movemask_ps(in), 4);
+	}
+
+	in_polygon_scalar(i, points, n, poly, m, inside);
+}
+
+TARGET("sse2")
+static void in_rect_1(const Vec2 *points, std::size_t n, Vec2 centre, Vec2 axis, float half_length, float half_width, std::uint8_t *inside) {
+	__m128 cx = _mm_set1_ps(centre.x), cy = _mm_set1_ps(centre.y);
+	__m128 ux = _mm_set1_ps(axis.x), uy = _mm_set1_ps(axis.y);
+	__m128 hl = _mm_set1_ps(half_length), hw = _mm_set1_ps(half_width);
+	__m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	std::size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128 x, y;
+		load_sse2(points + i, x, y);
+		x = _mm_sub_ps(x, cx);
+		y = _mm_sub_ps(y, cy);
+
+		__m128 along = _mm_add_ps(_mm_mul_ps(x, ux), _mm_mul_ps(y, uy));
+		__m128 across = _mm_sub_ps(_mm_mul_ps(y, ux), _mm_mul_ps(x, uy));
+
+		__m128 in = _mm_and_ps(
+			_mm_cmple_ps(_mm_and_ps(along, abs), hl),
+			_mm_cmple_ps(_mm_and_ps(across, abs), hw)
+		);
+
+		store_mask(inside + i, _mm_movemask_ps(in), 4);
+	}
+
+	in_rect_scalar(i, points, n, centre, axis, half_length, half_width, inside);
+}
+
+// as for SSE2, but the split leaves the 64-bit halves of each lane out of
+// order, so they are put back where the result is per point
+TARGET("avx2")
+static inline void load_avx2(const Vec2 *points, __m256 &x, __m256 &y, bool ordered) {
+	__m256 a = _mm256_loadu_ps(&points[0].x), b = _mm256_loadu_ps(&points[4].x);
+	x = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	y = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+	if (ordered) {
+		x = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(x), _MM_SHUFFLE(3, 1, 2, 0)));
+		y = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(y), _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+}
+
+TARGET("avx2")
+static std::size_t count_near_2(const Vec2 *points, std::size_t n, Vec2 start, Vec2 dir, float length, float radius) {
+	__m256 sx = _mm256_set1_ps(start.x), sy = _mm256_set1_ps(start.y);
+	__m256 ux = _mm256_set1_ps(dir.x), uy = _mm256_set1_ps(dir.y);
+	__m256 zero = _mm256_setzero_ps(), len = _mm256_set1_ps(length), r2 = _mm256_set1_ps(radius * radius);
+
+	std::size_t i = 0, count = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m256 x, y;
+		load_avx2(points + i, x, y, false);
+		x = _mm256_sub_ps(x, sx);
+		y = _mm256_sub_ps(y, sy);
+
+		__m256 along = _mm256_add_ps(_mm256_mul_ps(x, ux), _mm256_mul_ps(y, uy));
+		along = _mm256_min_ps(_mm256_max_ps(along, zero), len);
+
+		__m256 dx = _mm256_sub_ps(x, _mm256_mul_ps(along, ux));
+		__m256 dy = _mm256_sub_ps(y, _mm256_mul_ps(along, uy));
+		__m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+		count += std::popcount((unsigned) _mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ)));
+	}
+
+	return count + count_near_scalar(i, points, n, start, dir, length, radius);
+}
+
+TARGET("avx2")
+static void in_polygon_2(const Vec2 *points, std::size_t n, const Vec2 *poly, std::size_t m, std::uint8_t *inside) {
+	std::size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m256 x, y, in = _mm256_setzero_ps();
+		load_avx2(points + i, x, y, true);
+
+		for (std::size_t j = 0; j < m; j++) {
+			const auto &a = poly[j], &b = poly[j + 1 < m ? j + 1 : 0];
+			__m256 ax = _mm256_set1_ps(a.x), ay = _mm256_set1_ps(a.y);
+
+			__m256 straddle = _mm256_xor_ps(
+				_mm256_cmp_ps(ay, y, _CMP_GT_OQ),
+				_mm256_cmp_ps(_mm256_set1_ps(b.y), y, _CMP_GT_OQ)
+			);
+			if (!_mm256_movemask_ps(straddle)) continue;
+
+			__m256 t = _mm256_div_ps(_mm256_sub_ps(y, ay), _mm256_set1_ps(b.y - a.y));
+			__m256 cross = _mm256_add_ps(ax, _mm256_mul_ps(t, _mm256_set1_ps(b.x - a.x)));
+
+			in = _mm256_xor_ps(in, _mm256_and_ps(straddle, _mm256_cmp_ps(x, cross, _CMP_LT_OQ)));
+		}
+
+		store_mask(inside + i, _mm256_movemask_ps(in), 8);
+	}
+
+	in_polygon_scalar(i, points, n, poly, m, inside);
+}
+
+TARGET("avx2")
+static void in_rect_2(const Vec2 *points, std::size_t n, Vec2 centre, Vec2 axis, float half_length, float half_width, std::uint8_t *inside) {
+	__m256 cx = _mm256_set1_ps(centre.x), cy = _mm256_set1_ps(centre.y);
+	__m256 ux = _mm256_set1_ps(axis.x), uy = _mm256_set1_ps(axis.y);
+	__m256 hl = _mm256_set1_ps(half_length), hw = _mm256_set1_ps(half_width);
+	__m256 abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+	std::size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m256 x, y;
+		load_avx2(points + i, x, y, true);
+		x = _mm256_sub_ps(x, cx);
+		y = _mm256_sub_ps(y, cy);
+
+		__m256 along = _mm256_add_ps(_mm256_mul_ps(x, ux), _mm256_mul_ps(y, uy));
+		__m256 across = _mm256_sub_ps(_mm256_mul_ps(y, ux), _mm256_mul_ps(x, uy));
+
+		__m256 in = _mm256_and_ps(
+			_mm256_cmp_ps(_mm256_and_ps(along, abs), hl, _CMP_LE_OQ),
+			_mm256_cmp_ps(_mm256_and_ps(across, abs), hw, _CMP_LE_OQ)
+		);
+
+		store_mask(inside + i, _mm256_movemask_ps(in), 8);
+	}
+
+	in_rect_scalar(i, points, n, centre, axis, half_length, half_width, inside);
+}
+
+#ifdef _MSC_VER
+
+TARGET("xsave")
+static Isa detect() {
+	int info[4];
+
+	__cpuid(info, 0);
+	int max = info[0];
+
+	__cpuid(info, 1);
+	if (!(info[3] & 1 << 26)) return ISA_SCALAR;
+
+	// AVX state must also be enabled by the OS
+	bool avx = info[2] & 1 << 27 && info[2] & 1 << 28 && (_xgetbv(0) & 6) == 6;
+	if (!avx || max < 7) return ISA_SSE2;
+
+	__cpuidex(info, 7, 0);
+	return info[1] & 1 << 5 ? ISA_AVX2 : ISA_SSE2;
+}
+
+#else
+
+static Isa detect() {
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return ISA_AVX2;
+	if (__builtin_cpu_supports("sse2")) return ISA_SSE2;
+	return ISA_SCALAR;
+}
+
+#endif
+
+#else
+
+static Isa detect() {
+	return ISA_SCALAR;
+}
+
+#endif
+
+struct Table {
+	decltype(&count_near_0) count_near;
+	decltype(&in_polygon_0) in_polygon;
+	decltype(&in_rect_0) in_rect;
+};
+
+static const Table tables[ISA_COUNT] = {
+	{ count_near_0, in_polygon_0, in_rect_0 },
+#ifdef KERNELS_X86
+	{ count_near_1, in_polygon_1, in_rect_1 },
+	{ count_near_2, in_polygon_2, in_rect_2 },
+#endif
+};
+
+static Isa active = supported();
+
+Isa supported() {
+	static Isa isa = detect();
+	return isa;
+}
+
+Isa current() {
+	return active;
+}
+
+void select(Isa isa) {
+	active = std::min(isa, supported());
+}
+
+const char *isa_name(Isa isa) {
+	static const char *names[ISA_COUNT] = { "scalar", "sse2", "avx2" };
+	return names[isa];
+}
+
+std::size_t count_near(const Vec2 *points, std::size_t n, Vec2 start, Vec2 dir, float length, float radius) {
+	return tables[active].count_near(points, n, start, dir, length, radius);
+}
+
+void in_polygon(const Vec2 *points, std::size_t n, const Vec2 *poly, std::size_t m, std::uint8_t *inside) {
+	tables[active].in_polygon(points, n, poly, m, inside);
+}
+
+void in_rect(const Vec2 *points, std::size_t n, Vec2 centre, Vec2 axis, float half_length, float half_width, std::uint8_t *inside) {
+	tables[active].in_rect(points, n, centre, axis, half_length, half_width, inside);
+}
+
+}
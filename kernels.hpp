@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// east and north in metres
+struct Vec2 {
+	float x, y;
+};
+
+// batch geometry over arrays of points, with scalar, SSE2 and AVX2 versions;
+// the best one the processor supports is picked on first use
+namespace kernels {
+
+enum Isa {
+	ISA_SCALAR,
+	ISA_SSE2,
+	ISA_AVX2,
+	ISA_COUNT
+};
+
+Isa supported();
+Isa current();
+void select(Isa);
+const char *isa_name(Isa);
+
+// number of points within radius of the segment from start for length along
+// the unit vector dir
+std::size_t count_near(const Vec2 *, std::size_t, Vec2 start, Vec2 dir, float length, float radius);
+
+// whether each point is inside the polygon, by the even-odd rule
+void in_polygon(const Vec2 *, std::size_t, const Vec2 *poly, std::size_t, std::uint8_t *inside);
+
+// whether each point is inside the rectangle about centre, with its length
+// along the unit vector axis
+void in_rect(const Vec2 *, std::size_t, Vec2 centre, Vec2 axis, float half_length, float half_width, std::uint8_t *inside);
+
+}
@@ -0,0 +1,2733 @@
+#include "plugin.hpp"
+
+LocalFrame::LocalFrame(const EuroScope::CPosition &origin) {
+	lat0 = origin.m_Latitude * std::numbers::pi / 180.0;
+	lon0 = origin.m_Longitude * std::numbers::pi / 180.0;
+	sin_lat0 = std::sin(lat0);
+	cos_lat0 = std::cos(lat0);
+}
+
+Vec2 LocalFrame::project(const EuroScope::CPosition &posn) const {
+	double lat = posn.m_Latitude * std::numbers::pi / 180.0;
+	double dlon = posn.m_Longitude * std::numbers::pi / 180.0 - lon0;
+	double cos_lat = std::cos(lat);
+
+	return {
+		(float) (EARTH_RADIUS * cos_lat * std::sin(dlon)),
+		(float) (EARTH_RADIUS * (cos_lat0 * std::sin(lat) - sin_lat0 * cos_lat * std::cos(dlon))),
+	};
+}
+
+EuroScope::CPosition LocalFrame::unproject(Vec2 v) const {
+	double rho = std::hypot(v.x, v.y);
+	double c = std::asin(std::min(rho / EARTH_RADIUS, 1.0));
+	double sin_c = std::sin(c), cos_c = std::cos(c);
+
+	double lat = rho > 0 ? std::asin(cos_c * sin_lat0 + v.y * sin_c * cos_lat0 / rho) : lat0;
+	double lon = lon0 + std::atan2(v.x * sin_c, rho * cos_c * cos_lat0 - v.y * sin_c * sin_lat0);
+
+	EuroScope::CPosition posn;
+	posn.m_Latitude = lat * 180.0 / std::numbers::pi;
+	posn.m_Longitude = lon * 180.0 / std::numbers::pi;
+
+	return posn;
+}
+
+ClosedArea::ClosedArea(std::vector<EuroScope::CPosition> points, std::uint32_t aerodrome, const LocalFrame &frame)
+	: poly(std::move(points)), aerodrome(aerodrome) {
+	x0 = y0 = INFINITY;
+	x1 = y1 = -INFINITY;
+
+	for (const auto &p : poly) {
+		auto v = local.emplace_back(frame.project(p));
+
+		x0 = std::min(x0, v.x);
+		y0 = std::min(y0, v.y);
+		x1 = std::max(x1, v.x);
+		y1 = std::max(y1, v.y);
+	}
+
+	size_t count = std::max<size_t>(local.size() / 4, 1);
+	band = std::max((y1 - y0) / count, 1e-3f);
+	bands.resize(count);
+
+	for (std::uint32_t i = 0; i < local.size(); i++) {
+		const auto &a = local[i], &b = local[(i + 1) % local.size()];
+
+		auto first = (size_t) ((std::min(a.y, b.y) - y0) / band);
+		auto last = (size_t) ((std::max(a.y, b.y) - y0) / band);
+
+		for (size_t j = first; j <= std::min(last, count - 1); j++) bands[j].push_back(i);
+	}
+}
+
+bool ClosedArea::contains(Vec2 p) const {
+	if (p.x < x0 || p.x > x1 || p.y < y0 || p.y > y1) return false;
+
+	bool inside = false;
+
+	for (auto i : bands[std::min((size_t) ((p.y - y0) / band), bands.size() - 1)]) {
+		const auto &a = local[i], &b = local[(i + 1) % local.size()];
+
+		if ((a.y > p.y) == (b.y > p.y)) continue;
+
+		float t = (p.y - a.y) / (b.y - a.y);
+		if (p.x < a.x + t * (b.x - a.x)) inside = !inside;
+	}
+
+	return inside;
+}
+
+void TimerWheel::insert(TimerTask *task) {
+	std::uint64_t delta = task->expiry - now;
+	int level = 0;
+
+	while (level < LEVELS - 1 && delta >= (std::uint64_t) 1 << (SLOT_BITS * (level + 1))) level++;
+
+	if (delta >= (std::uint64_t) 1 << (SLOT_BITS * LEVELS))
+		task->expiry = now + ((std::uint64_t) 1 << (SLOT_BITS * LEVELS)) - 1;
+
+	TimerTask **head = &slots[level][(task->expiry >> (SLOT_BITS * level)) & (SLOTS - 1)];
+
+	task->prev = nullptr;
+	task->next = *head;
+	task->list = head;
+	if (*head) (*head)->prev = task;
+	*head = task;
+}
+
+void TimerWheel::unlink(TimerTask *task) {
+	if (task->prev) task->prev->next = task->next;
+	else *task->list = task->next;
+
+	if (task->next) task->next->prev = task->prev;
+
+	task->prev = task->next = nullptr;
+	task->list = nullptr;
+}
+
+void TimerWheel::destroy(TimerTask *task) {
+	size_t index = task->index;
+
+	std::swap(tasks[index], tasks.back());
+	tasks[index]->index = index;
+	tasks.pop_back();
+}
+
+void TimerWheel::cascade(int level, int slot) {
+	TimerTask *task = slots[level][slot];
+	slots[level][slot] = nullptr;
+
+	while (task) {
+		TimerTask *next = task->next;
+		insert(task);
+		task = next;
+	}
+}
+
+TimerTask *TimerWheel::schedule(std::string name, unsigned interval, std::function<void()> callback, unsigned delay) {
+	auto task = std::make_unique<TimerTask>();
+
+	task->name = std::move(name);
+	task->callback = std::move(callback);
+	task->interval = interval;
+	task->expiry = now + std::max(delay ? delay : interval, 1u);
+	task->index = tasks.size();
+	task->cancelled = false;
+	task->runs = 0;
+	task->total = task->max = {};
+
+	insert(task.get());
+
+	return tasks.emplace_back(std::move(task)).get();
+}
+
+void TimerWheel::cancel(TimerTask *task) {
+	if (task->list) {
+		unlink(task);
+		destroy(task);
+	} else {
+		// currently running; dropped once its callback returns
+		task->cancelled = true;
+	}
+}
+
+void TimerWheel::tick() {
+	now++;
+
+	if (!(now & (SLOTS - 1))) {
+		for (int level = 1; level < LEVELS; level++) {
+			int slot = (now >> (SLOT_BITS * level)) & (SLOTS - 1);
+			cascade(level, slot);
+			if (slot) break;
+		}
+	}
+
+	TimerTask **head = &slots[0][now & (SLOTS - 1)];
+	pending = *head;
+	*head = nullptr;
+
+	for (TimerTask *task = pending; task; task = task->next) task->list = &pending;
+
+	while (pending) {
+		TimerTask *task = pending;
+		unlink(task);
+
+		auto start = std::chrono::steady_clock::now();
+		task->callback();
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		task->runs++;
+		task->total += elapsed;
+		task->max = std::max(task->max, elapsed);
+
+		if (task->cancelled || !task->interval) {
+			destroy(task);
+		} else {
+			task->expiry = now + task->interval;
+			insert(task);
+		}
+	}
+}
+
+std::uint32_t CallsignTable::find(std::string_view callsign) const {
+	auto it = handles.find(callsign);
+	return it == handles.cend() ? NONE : std::get<1>(*it);
+}
+
+std::uint32_t CallsignTable::intern(std::string_view callsign) {
+	auto it = handles.find(callsign);
+	if (it != handles.cend()) return std::get<1>(*it);
+
+	std::uint32_t handle;
+	if (unused.empty()) {
+		handle = names.size();
+		names.emplace_back(callsign);
+	} else {
+		handle = unused.back();
+		unused.pop_back();
+		names[handle] = callsign;
+	}
+
+	handles.emplace(names[handle], handle);
+
+	return handle;
+}
+
+void CallsignTable::release(std::uint32_t handle) {
+	handles.erase(names[handle]);
+	names[handle].clear();
+	unused.push_back(handle);
+}
+
+static GroundState decode_ground_state(const char *gs) {
+	if (!*gs) return GS_NONE;
+	if (!std::strcmp(gs, "STUP")) return GS_STUP;
+	if (!std::strcmp(gs, "PUSH")) return GS_PUSH;
+	if (!std::strcmp(gs, "TAXI")) return GS_TAXI;
+	if (!std::strcmp(gs, "DEPA")) return GS_DEPA;
+	return GS_OTHER;
+}
+
+static bool parse_option(Options &options, const std::string &name, const std::string &value) {
+	static const std::pair<const char *, double Options::*> fields[] = {
+		{ "warn_lookahead", &Options::warn_lookahead },
+		{ "final_alert", &Options::final_alert },
+		{ "approach_ceiling", &Options::approach_ceiling },
+		{ "conflict_radius", &Options::conflict_radius },
+		{ "conflict_horizon", &Options::conflict_horizon },
+		{ "trail_length", &Options::trail_length },
+		{ "trail_decimation", &Options::trail_decimation },
+	};
+
+	char *end;
+	double number = std::strtod(value.c_str(), &end);
+	if (*end) return false;
+
+	for (const auto &[field_name, field] : fields) {
+		if (name == field_name) {
+			options.*field = number;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// size code (0 for A to 5 for F) typical of each wake turbulence category
+static int size_code(char wtc) {
+	switch (wtc) {
+		case 'L': return 0;
+		case 'H': return 4;
+		case 'J': return 5;
+		default: return 2;
+	}
+}
+
+void TaxiGraph::add_edge(std::uint32_t a, std::uint32_t b, std::uint32_t taxiway) {
+	const auto &p = nodes[a], &q = nodes[b];
+	float length = std::hypot(q.x - p.x, q.y - p.y);
+
+	edge_grid.insert(std::min(p.x, q.x), std::min(p.y, q.y), std::max(p.x, q.x), std::max(p.y, q.y), edges.size());
+	adjacent[a].push_back(edges.size());
+	adjacent[b].push_back(edges.size());
+	edges.push_back({ a, b, taxiway, length });
+	blocked.push_back(0);
+}
+
+std::uint32_t TaxiGraph::node(Vec2 p, const EuroScope::CPosition &posn) {
+	auto id = nearest(p, TAXI_SNAP_DIST);
+	if (id != UINT32_MAX) return id;
+
+	id = nodes.size();
+	nodes.push_back(p);
+	positions.push_back(posn);
+	adjacent.emplace_back();
+	grid.insert(p.x, p.y, p.x, p.y, id);
+
+	return id;
+}
+
+void TaxiGraph::add(const std::string &taxiway, const std::vector<Vec2> &points, const std::vector<EuroScope::CPosition> &posns) {
+	auto it = std::find(taxiways.begin(), taxiways.end(), taxiway);
+	auto t = (std::uint32_t) (it - taxiways.begin());
+	if (it == taxiways.end()) taxiways.push_back(taxiway);
+
+	auto a = node(points[0], posns[0]);
+	for (size_t i = 1; i < points.size(); i++) {
+		auto b = node(points[i], posns[i]);
+		if (a != b) add_edge(a, b, t);
+		a = b;
+	}
+}
+
+// a node at p, joined to the nearest node within TAXI_LINK_DIST by an edge
+// on no taxiway if it is not on the network already
+std::uint32_t TaxiGraph::link(Vec2 p, const EuroScope::CPosition &posn) {
+	auto count = nodes.size();
+	auto id = node(p, posn);
+	if (nodes.size() == count) return id;
+
+	auto to = nearest(p, TAXI_LINK_DIST, id);
+	if (to != UINT32_MAX) add_edge(id, to, UINT32_MAX);
+
+	return id;
+}
+
+std::uint32_t TaxiGraph::nearest(Vec2 p, float range, std::uint32_t except) const {
+	std::uint32_t nearest = UINT32_MAX;
+	float nearest_dist = range;
+
+	grid.query(p.x - range, p.y - range, p.x + range, p.y + range, [&](std::uint32_t id) {
+		float dist = std::hypot(nodes[id].x - p.x, nodes[id].y - p.y);
+		if (id != except && dist <= nearest_dist) {
+			nearest = id;
+			nearest_dist = dist;
+		}
+	});
+
+	return nearest;
+}
+
+// replaces the set of closed edges; if edges were only closed, cached routes
+// that avoid all of them are still the shortest, and are kept
+void TaxiGraph::block(std::vector<std::uint8_t> next) {
+	bool opened = false;
+	std::vector<std::uint32_t> closed;
+
+	for (std::uint32_t e = 0; e < edges.size(); e++) {
+		if (blocked[e] && !next[e]) opened = true;
+		if (!blocked[e] && next[e]) closed.push_back(e);
+	}
+
+	if (!opened && closed.empty()) return;
+
+	blocked = std::move(next);
+	auto previous = generation++;
+
+	if (opened) return;
+
+	for (auto &[_, route] : routes) {
+		if (route.generation != previous) continue;
+
+		bool affected = std::any_of(route.edges.begin(), route.edges.end(), [&](std::uint32_t e) { return blocked[e]; });
+		if (!affected && !route.edges.empty()) route.generation = generation;
+	}
+}
+
+// shortest open route from one node to another as a list of edges, by A*
+// with the straight-line distance; null if there is none
+const std::vector<std::uint32_t> *TaxiGraph::route(std::uint32_t from, std::uint32_t to) {
+	auto key = (std::uint64_t) from << 32 | to;
+
+	auto it = routes.find(key);
+	if (it != routes.end() && std::get<1>(*it).generation == generation) {
+		hits++;
+	} else {
+		misses++;
+
+		Route route = { generation, {} };
+		search(
+			from,
+			[to](std::uint32_t n) { return n == to; },
+			[this](std::uint32_t e) { return !blocked[e]; },
+			[&](std::uint32_t n) { return std::hypot(nodes[to].x - nodes[n].x, nodes[to].y - nodes[n].y); },
+			route.edges
+		);
+
+		it = routes.insert_or_assign(key, std::move(route)).first;
+	}
+
+	const auto &edges = std::get<1>(*it).edges;
+	return edges.empty() && from != to ? nullptr : &edges;
+}
+
+// marks the aircraft on or near the radar area; the area is found as a
+// rectangle in each aerodrome's frame, as the display may be rotated
+void Screen::find_visible(RECT crop) {
+	const auto &ac_local = plugin->ac_local;
+	const auto &ac_aerodrome = plugin->ac_aerodrome;
+
+	visible.assign(ac_local.size(), 0);
+	inside.resize(ac_local.size());
+
+	POINT corners[3] = {
+		{ crop.left - QNH_HIGHLIGHT_SIZE, crop.top - QNH_HIGHLIGHT_SIZE },
+		{ crop.right + QNH_HIGHLIGHT_SIZE, crop.top - QNH_HIGHLIGHT_SIZE },
+		{ crop.left - QNH_HIGHLIGHT_SIZE, crop.bottom + QNH_HIGHLIGHT_SIZE },
+	};
+
+	for (std::uint32_t i = 0; i < plugin->aerodromes.size(); i++) {
+		const auto &frame = plugin->aerodromes[i].frame;
+
+		Vec2 c[3];
+		for (int j = 0; j < 3; j++) c[j] = frame.project(ConvertCoordFromPixelToPosition(corners[j]));
+
+		Vec2 across = { c[1].x - c[0].x, c[1].y - c[0].y }, down = { c[2].x - c[0].x, c[2].y - c[0].y };
+		float length = std::hypot(across.x, across.y), width = std::hypot(down.x, down.y);
+		if (length <= 0) continue;
+
+		Vec2 centre = { c[0].x + (across.x + down.x) / 2, c[0].y + (across.y + down.y) / 2 };
+		Vec2 axis = { across.x / length, across.y / length };
+
+		kernels::in_rect(ac_local.data(), ac_local.size(), centre, axis, length / 2, width / 2, inside.data());
+
+		for (std::uint32_t ac = 0; ac < inside.size(); ac++)
+			if (inside[ac] && ac_aerodrome[ac] == i) visible[ac] = 1;
+	}
+
+	// aircraft away from every aerodrome have no frame to test in
+	for (std::uint32_t ac = 0; ac < visible.size(); ac++)
+		if (ac_aerodrome[ac] == UINT32_MAX) visible[ac] = 1;
+}
+
+// the rings to draw, in drawing order; worked out apart from the drawing so
+// it can be run without a display
+void Screen::find_highlights(RECT crop) {
+	find_visible(crop);
+	highlights.clear();
+
+	auto highlight = [&](std::uint32_t ac, Mark mark, int size) {
+		if (visible[ac]) highlights.push_back({ ac, mark, size });
+	};
+
+	plugin->ground_state_set[GS_STUP].for_each([&](std::uint32_t ac) {
+		highlight(ac, MARK_STUP, HIGHLIGHT_SIZE);
+	});
+
+	plugin->ground_state_set[GS_PUSH].for_each([&](std::uint32_t ac) {
+		highlight(ac, MARK_PUSH, HIGHLIGHT_SIZE);
+	});
+
+	plugin->ground_state_set[GS_TAXI].for_each([&](std::uint32_t ac) {
+		if ((plugin->ac_flags[ac] & (AC_WARN | AC_DEHIGHLIGHT)) != AC_WARN) return;
+
+		/* auto half = HIGHLIGHT_SIZE / 2;
+		POINT c = ConvertCoordFromPositionToPixel(plugin->ac_position[ac]);
+		RECT area = { c.x - half, c.y - half, c.x + half, c.y + half };
+		AddScreenObject(OBJECT_TYPE_DEHIGHLIGHT, plugin->callsigns.name(ac).c_str(), area, false, "Dehighlight"); */
+
+		highlight(ac, MARK_WARN, HIGHLIGHT_SIZE);
+	});
+
+	plugin->pressure_due.for_each([&](std::uint32_t ac) {
+		highlight(ac, MARK_QNH, QNH_HIGHLIGHT_SIZE);
+	});
+
+	plugin->in_closed.for_each([&](std::uint32_t ac) {
+		highlight(ac, MARK_CLSD, HIGHLIGHT_SIZE);
+	});
+
+	plugin->routed.for_each([&](std::uint32_t ac) {
+		auto flags = plugin->ac_flags[ac];
+
+		if (flags & AC_OVERRUN) highlight(ac, MARK_CLSD, QNH_HIGHLIGHT_SIZE);
+		else if (flags & (AC_DEVIATION | AC_BLOCKED)) highlight(ac, MARK_WARN, QNH_HIGHLIGHT_SIZE);
+	});
+
+	for (const auto &rwy : plugin->runways) {
+		if (!rwy.conflict) continue;
+
+		for (auto ac : rwy.occupants) highlight(ac, MARK_RWY, HIGHLIGHT_SIZE);
+		for (auto ac : rwy.finals) highlight(ac, MARK_RWY, HIGHLIGHT_SIZE);
+	}
+}
+
+// one block per runway with arrivals, each followed by an empty line, then
+// each departure queue with its waits so far
+void Screen::list_lines() {
+	lines.clear();
+
+	for (const auto &seq : plugin->sequences) {
+		if (seq.arrivals.empty()) continue;
+
+		lines.push_back(plugin->aerodromes[seq.aerodrome].name + " " + seq.runway);
+
+		for (auto ac : seq.arrivals) {
+			char eta_text[16];
+			std::time_t eta = plugin->ac_eta[ac];
+			std::strftime(eta_text, sizeof eta_text, "%H:%M", std::gmtime(&eta));
+
+			lines.push_back(std::to_string(plugin->ac_landing[ac]) + " " + plugin->callsigns.name(ac) + " " + eta_text);
+		}
+
+		lines.emplace_back();
+	}
+
+	auto minutes = [](double seconds) {
+		char text[16];
+		std::snprintf(text, sizeof text, "%d:%02d", (int) seconds / 60, (int) seconds % 60);
+		return std::string(text);
+	};
+
+	for (const auto &ad : plugin->aerodromes) {
+		for (const auto &queue : ad.queues) {
+			if (queue.aircraft.empty() && !queue.waits) continue;
+
+			std::string line = ad.name + " " + queue.runway + " " + queue.name + " " + std::to_string(queue.aircraft.size());
+			if (queue.waits)
+				line += " avg " + minutes(queue.total_wait / queue.waits) + " p90 " + minutes(queue.wait_p90.value());
+
+			lines.push_back(std::move(line));
+		}
+	}
+}
+
+void Screen::OnClickScreenObject(int type, const char *id, POINT, RECT, int button) {
+	if (button == EuroScope::BUTTON_RIGHT) {
+		if (type == OBJECT_TYPE_HOTSPOT) {
+			auto fpl = plugin->FlightPlanSelectASEL();
+			if (fpl.IsValid()) {
+				fpl.GetControllerAssignedData().SetScratchPadString("TAXI");
+				fpl.GetControllerAssignedData().SetScratchPadString(id);
+			}
+		} else if (type == OBJECT_TYPE_DEHIGHLIGHT) {
+			plugin->ac_flags[plugin->aircraft(id)] |= AC_DEHIGHLIGHT;
+		}
+	}
+}
+
+void Screen::OnRefresh(HDC hdc, int phase) {
+	auto start = std::chrono::steady_clock::now();
+	draw(hdc, phase);
+
+	auto &recorder = plugin->recorder;
+	if (!recorder.active()) return;
+
+	EuroScope::CPosition sw, ne;
+	GetDisplayArea(&sw, &ne);
+
+	recorder.view(GetRadarArea(), sw, ne);
+	recorder.refresh(phase, std::chrono::steady_clock::now() - start);
+}
+
+Screen *Plugin::OnRadarScreenCreated(const char *name, bool, bool, bool geo, bool) {
+	return geo && !std::strcmp(name, ASR_TYPE) ? new Screen(this) : nullptr;
+}
+
+void Plugin::OnAirportRunwayActivityChanged() {
+	recorder.runways(*this);
+	load();
+}
+
+void Plugin::OnFlightPlanDisconnect(EuroScope::CFlightPlan fp) {
+	recorder.disconnect(fp);
+
+	auto ac = callsigns.find(fp.GetCallsign());
+	if (ac == CallsignTable::NONE) return;
+
+	set_pressure_due(fp, ac, false);
+	release(ac);
+}
+
+void Plugin::OnFlightPlanFlightPlanDataUpdate(EuroScope::CFlightPlan fp) {
+	recorder.flight_plan(fp);
+
+	auto ac = aircraft(fp.GetCallsign());
+
+	set_origin(ac, fp.GetFlightPlanData().GetOrigin());
+	set_ground_state(ac, decode_ground_state(fp.GetGroundState()));
+	update_assigned(ac, fp);
+	ac_arrival[ac] = {};
+}
+
+void Plugin::OnFlightPlanControllerAssignedDataUpdate(EuroScope::CFlightPlan fp, int type) {
+	recorder.assigned(fp, type);
+
+	auto ac = aircraft(fp.GetCallsign());
+
+	switch (type) {
+		case EuroScope::CTR_DATA_TYPE_GROUND_STATE:
+			set_ground_state(ac, decode_ground_state(fp.GetGroundState()));
+			break;
+
+		case EuroScope::CTR_DATA_TYPE_SCRATCH_PAD_STRING:
+			ac_scratchpad[ac] = fp.GetControllerAssignedData().GetScratchPadString();
+			update_warn(ac);
+			break;
+	}
+
+	update_assigned(ac, fp);
+	ac_arrival[ac] = {};
+}
+
+bool Plugin::OnCompileCommand(const char *cmd) {
+	recorder.command(cmd);
+
+	if (!std::strcmp(cmd, ".reloadvsmrplus")) {
+		load();
+		return true;
+	}
+
+	if (!std::strcmp(cmd, ".statsvsmrplus")) {
+		stats();
+		return true;
+	}
+
+	if (!std::strcmp(cmd, ".crossingsvsmrplus")) {
+		list_crossings();
+		return true;
+	}
+
+	if (!std::strncmp(cmd, ".recordvsmrplus", 15) && (!cmd[15] || cmd[15] == ' ')) {
+		record(cmd[15] ? cmd + 16 : nullptr);
+		return true;
+	}
+
+	bool close = !std::strncmp(cmd, ".closevsmrplus ", 15), open = !std::strncmp(cmd, ".openvsmrplus ", 14);
+	if (close || open) {
+		std::string taxiway = cmd + (close ? 15 : 14);
+
+		if (close) closed_taxiways.insert(taxiway);
+		else closed_taxiways.erase(taxiway);
+
+		update_closures();
+		return true;
+	}
+
+	return false;
+}
+
+void Plugin::OnFunctionCall(int code, const char *item, POINT, RECT area) {
+	auto fp = FlightPlanSelectASEL();
+	recorder.function(code, item, fp);
+
+	if (!fp.IsValid()) return;
+
+	switch (code) {
+		case TAG_FUNC_STAND: {
+			auto it1 = stands.find(fp.GetFlightPlanData().GetOrigin());
+			if (it1 == stands.cend()) return;
+
+			auto std = fp.GetControllerAssignedData().GetFlightStripAnnotation(3);
+			auto it2 = std::get<1>(*it1).find(std);
+			if (it2 == std::get<1>(*it1).cend()) return;
+
+			const std::string &details = std::get<1>(*it2).details;
+			if (details.empty()) return;
+
+			DisplayUserMessage(PLUGIN_NAME, std, details.c_str(), true, true, false, false, false);
+
+			break;
+		}
+
+		case TAG_FUNC_STAND_ALLOCATE:
+			allocate_stand(fp, area);
+
+			break;
+
+		case TAG_FUNC_STAND_SELECT:
+			fp.GetControllerAssignedData().SetFlightStripAnnotation(3, item);
+			update_assigned(aircraft(fp.GetCallsign()), fp);
+
+			break;
+
+		case TAG_FUNC_ROUTE: {
+			auto ac = aircraft(fp.GetCallsign());
+			if (ac_aerodrome[ac] == UINT32_MAX) return;
+
+			// offer the holding points for the departure runway, if it has any
+			const auto &holds = aerodromes[ac_aerodrome[ac]].holds;
+			std::string rwy = fp.GetFlightPlanData().GetDepartureRwy();
+			bool any = std::any_of(holds.begin(), holds.end(), [&](const auto &hold) { return hold.runway == rwy; });
+
+			OpenPopupList(area, "Taxi to", 2);
+
+			for (std::uint32_t i = 0; i < holds.size(); i++) {
+				if (any && holds[i].runway != rwy) continue;
+
+				bool current = routed.contains(ac) && ac_route[ac].hold == i;
+				AddPopupListElement(holds[i].name.c_str(), holds[i].runway.c_str(), TAG_FUNC_ROUTE_SELECT, current);
+			}
+
+			AddPopupListElement("Clear", "", TAG_FUNC_ROUTE_CLEAR, false, EuroScope::POPUP_ELEMENT_NO_CHECKBOX, false, true);
+
+			break;
+		}
+
+		case TAG_FUNC_ROUTE_SELECT: {
+			auto ac = aircraft(fp.GetCallsign());
+			auto ad = ac_aerodrome[ac];
+			if (ad == UINT32_MAX) return;
+
+			const auto &holds = aerodromes[ad].holds;
+			auto it = std::find_if(holds.begin(), holds.end(), [&](const auto &hold) { return hold.name == item; });
+			if (it == holds.end()) return;
+
+			auto from = aerodromes[ad].taxi.nearest(ac_local[ac], TAXI_LINK_DIST);
+			if (from == UINT32_MAX || !set_route(ac, ad, from, it - holds.begin()))
+				warn(("no taxi route for " + callsigns.name(ac) + " to " + it->name).c_str());
+
+			break;
+		}
+
+		case TAG_FUNC_ROUTE_CLEAR:
+			set_route(aircraft(fp.GetCallsign()), UINT32_MAX, UINT32_MAX, UINT32_MAX);
+
+			break;
+
+		case TAG_FUNC_ROUTE_EDIT: {
+			auto ac = aircraft(fp.GetCallsign());
+			auto text = routed.contains(ac) ? route_text(ac_route[ac]) : std::string();
+
+			OpenPopupEdit(area, TAG_FUNC_ROUTE_EDITED, text.c_str());
+
+			break;
+		}
+
+		case TAG_FUNC_ROUTE_EDITED: {
+			auto ac = aircraft(fp.GetCallsign());
+
+			if (!*item) set_route(ac, UINT32_MAX, UINT32_MAX, UINT32_MAX);
+			else if (!parse_route(ac, item)) warn(("cannot follow taxi route " + std::string(item)).c_str());
+
+			break;
+		}
+
+		case TAG_FUNC_STOP_BAR: {
+			auto ac = aircraft(fp.GetCallsign());
+			if (ac_aerodrome[ac] == UINT32_MAX) return;
+
+			// as for holding points, the departure runway's bars come first
+			const auto &bars = aerodromes[ac_aerodrome[ac]].bars;
+			std::string rwy = fp.GetFlightPlanData().GetDepartureRwy();
+			bool any = std::any_of(bars.begin(), bars.end(), [&](const auto &bar) { return bar.runway == rwy; });
+
+			// bars are named within their runway, and only the item text
+			// comes back, so it names both
+			OpenPopupList(area, "Stop bars", 1);
+
+			for (const auto &bar : bars) {
+				if (any && bar.runway != rwy) continue;
+
+				AddPopupListElement((bar.runway + " " + bar.name).c_str(), "", TAG_FUNC_STOP_BAR_TOGGLE, false, bar.lit);
+			}
+
+			break;
+		}
+
+		case TAG_FUNC_STOP_BAR_TOGGLE: {
+			auto ad = ac_aerodrome[aircraft(fp.GetCallsign())];
+			if (ad == UINT32_MAX) return;
+
+			std::string_view text = item;
+			auto space = text.find(' ');
+			if (space == text.npos) return;
+
+			auto rwy = text.substr(0, space), name = text.substr(space + 1);
+			for (auto &bar : aerodromes[ad].bars)
+				if (bar.runway == rwy && bar.name == name) bar.lit = !bar.lit;
+
+			break;
+		}
+
+		case TAG_FUNC_DEHIGHLIGHT: {
+			auto ac = aircraft(fp.GetCallsign());
+
+			if (ac_flags[ac] & AC_DEHIGHLIGHT)
+				ac_flags[ac] &= ~AC_DEHIGHLIGHT;
+			else if (ac_ground_state[ac] == GS_TAXI)
+				ac_flags[ac] |= AC_DEHIGHLIGHT;
+
+			break;
+		}
+
+		case TAG_FUNC_PRESSURE_UPDATE: {
+			auto it = ad_pressure.find(fp.GetFlightPlanData().GetOrigin());
+			if (it != ad_pressure.cend()) {
+				auto ac = aircraft(fp.GetCallsign());
+				ac_pressure[ac] = std::get<1>(*it);
+				ac_flags[ac] |= AC_PRESSURE;
+				set_pressure_due(fp, ac, false);
+			}
+
+			break;
+		}
+
+		case TAG_FUNC_PRESSURE_RESET: {
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE) return;
+
+			ac_flags[ac] &= ~AC_PRESSURE;
+			set_pressure_due(fp, ac, false);
+
+			break;
+		}
+	}
+}
+
+void Plugin::OnRadarTargetPositionUpdate(EuroScope::CRadarTarget rt) {
+	recorder.position(rt);
+
+	auto ac = aircraft(rt.GetCallsign());
+	ac_seen[ac] = timers.time();
+
+	auto posn = rt.GetPosition();
+	auto last_ad = ac_aerodrome[ac];
+	auto last = ac_local[ac];
+	set_position(ac, posn.GetPosition());
+	ac_altitude[ac] = posn.GetPressureAltitude();
+	ac_gs[ac] = rt.GetGS();
+	ac_track[ac] = rt.GetTrackHeading();
+
+	trails.push(ac, ac_position[ac]);
+
+	update_warn(ac);
+	update_closed(ac);
+	update_runway(ac);
+	update_stand(ac);
+	update_taxiway(ac);
+	check_bars(ac, last_ad, last);
+	update_queue(ac);
+	update_arrival(ac, rt.GetCorrelatedFlightPlan());
+}
+
+void Plugin::OnGetTagItem(EuroScope::CFlightPlan fp, EuroScope::CRadarTarget, int code, int, char string[16], int *colour, COLORREF *rgb, double *) {
+	recorder.tag_items++;
+
+	if (!fp.IsValid()) return;
+
+	switch (code) {
+		case TAG_ITEM_STAND: {
+			string[0] = 0;
+
+			if (fp.GetDistanceFromOrigin() > STAND_ORIGIN_DIST) return;
+
+			auto it1 = stands.find(fp.GetFlightPlanData().GetOrigin());
+			if (it1 == stands.cend()) return;
+
+			auto it2 = std::get<1>(*it1).find(fp.GetControllerAssignedData().GetFlightStripAnnotation(3));
+			if (it2 == std::get<1>(*it1).cend()) return;
+
+			auto stand = std::get<1>(*it2);
+
+			char engine_type = fp.GetFlightPlanData().GetEngineType();
+			bool prop = engine_type == 'P' || engine_type == 'T';
+
+			string[0] = prop ? stand.prop_letter : stand.letter;
+			string[1] = 0;
+
+			auto index = stand.index == UINT32_MAX ? stand_index.cend() : stand_index.find(std::get<0>(*it1));
+			if (index != stand_index.cend()) {
+				auto occupant = std::get<1>(*index).occupant[stand.index];
+				if (occupant != UINT32_MAX && callsigns.name(occupant) != fp.GetCallsign()) {
+					string[1] = '!';
+					string[2] = 0;
+				}
+			}
+
+			*colour = EuroScope::TAG_COLOR_RGB_DEFINED;
+			*rgb = COLOUR_STAND[prop ? stand.prop_colour : stand.colour];
+
+			break;
+		}
+
+		case TAG_ITEM_DEHIGHLIGHT: {
+			auto ac = callsigns.find(fp.GetCallsign());
+			bool dehighlighted = ac != CallsignTable::NONE && ac_flags[ac] & AC_DEHIGHLIGHT;
+
+			string[0] = dehighlighted ? CHAR_BOX_FILLED : CHAR_BOX_EMPTY;
+			string[1] = 0;
+
+			*colour = EuroScope::TAG_COLOR_DEFAULT;
+
+			break;
+		}
+
+		case TAG_ITEM_PRESSURE: {
+			string[0] = 0;
+
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE || !(ac_flags[ac] & AC_PRESSURE)) return;
+
+			bool ok = false;
+			auto it = ad_pressure.find(fp.GetFlightPlanData().GetOrigin());
+			if (it != ad_pressure.cend()) ok = ac_pressure[ac] == std::get<1>(*it);
+
+			strncpy_s(string, 12, ac_pressure[ac].data(), 2);
+
+			*colour = ok ? EuroScope::TAG_COLOR_REDUNDANT : EuroScope::TAG_COLOR_INFORMATION;
+
+			break;
+		}
+
+		case TAG_ITEM_ROUTE: {
+			string[0] = 0;
+
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE || !routed.contains(ac)) return;
+
+			auto text = route_text(ac_route[ac]);
+			strncpy_s(string, 16, text.c_str(), std::min<size_t>(text.size(), 15));
+
+			*colour = EuroScope::TAG_COLOR_DEFAULT;
+
+			break;
+		}
+
+		case TAG_ITEM_TAXIWAY: {
+			string[0] = 0;
+
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE || ac_edge[ac] == UINT32_MAX) return;
+
+			const auto &graph = aerodromes[ac_aerodrome[ac]].taxi;
+			auto t = graph.edges[ac_edge[ac]].taxiway;
+			if (t == UINT32_MAX) return;
+
+			strncpy_s(string, 16, graph.taxiways[t].c_str(), std::min<size_t>(graph.taxiways[t].size(), 15));
+
+			*colour = EuroScope::TAG_COLOR_DEFAULT;
+
+			break;
+		}
+
+		case TAG_ITEM_CONFORMANCE: {
+			string[0] = 0;
+
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE) return;
+
+			if (ac_flags[ac] & AC_OVERRUN) strncpy_s(string, 16, "HOLD", 4);
+			else if (ac_flags[ac] & AC_DEVIATION) strncpy_s(string, 16, "DEV", 3);
+			else if (ac_flags[ac] & AC_BLOCKED) strncpy_s(string, 16, "BLKD", 4);
+
+			*colour = EuroScope::TAG_COLOR_EMERGENCY;
+
+			break;
+		}
+
+		case TAG_ITEM_SEQUENCE: {
+			string[0] = 0;
+
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE || !ac_landing[ac]) return;
+
+			std::snprintf(string, 16, "%u", ac_landing[ac]);
+
+			*colour = EuroScope::TAG_COLOR_DEFAULT;
+
+			break;
+		}
+
+		case TAG_ITEM_QUEUE: {
+			string[0] = 0;
+
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE) return;
+
+			auto [ad, queue] = ac_queue[ac];
+			if (queue == UINT32_MAX) return;
+
+			const auto &area = aerodromes[ad].queues[queue];
+			auto position = (std::uint32_t) (std::find(area.aircraft.begin(), area.aircraft.end(), ac) - area.aircraft.begin() + 1);
+
+			std::snprintf(string, 16, "%s %u", area.name.c_str(), position);
+
+			*colour = EuroScope::TAG_COLOR_DEFAULT;
+
+			break;
+		}
+
+		case TAG_ITEM_CLOSED: {
+			string[0] = 0;
+
+			auto ac = callsigns.find(fp.GetCallsign());
+			if (ac == CallsignTable::NONE || !in_closed.contains(ac)) return;
+
+			strncpy_s(string, 16, "CLSD", 4);
+
+			*colour = EuroScope::TAG_COLOR_EMERGENCY;
+
+			break;
+		}
+	}
+}
+
+void Plugin::OnNewMetarReceived(const char *ad, const char *metar) {
+	recorder.metar(ad, metar);
+
+	// selon Annex 4, il y a jamais un "Q" avant la pression
+	const char *q = std::strchr(metar, 'Q');
+	std::array<char, 3> pressure = { q[3], q[4], 0 };
+
+	auto &current = ad_pressure[ad];
+	if (current == pressure) return;
+
+	current = pressure;
+
+	auto it = ad_aircraft.find(ad);
+	if (it == ad_aircraft.cend()) return;
+
+	for (auto ac : std::get<1>(*it)) {
+		if (!(ac_flags[ac] & AC_PRESSURE)) continue;
+
+		bool due = ac_pressure[ac] != current;
+		if (due == pressure_due.contains(ac)) continue;
+
+		set_pressure_due(FlightPlanSelect(callsigns.name(ac).c_str()), ac, due);
+	}
+}
+
+void Plugin::OnTimer(int counter) {
+	recorder.timer(counter);
+	recorder.flush();
+
+	timers.tick();
+}
+
+void Plugin::init() {
+	RegisterTagItemType("Stand information", TAG_ITEM_STAND);
+	RegisterTagItemFunction("Show detailed stand information", TAG_FUNC_STAND);
+	RegisterTagItemFunction("Allocate stand", TAG_FUNC_STAND_ALLOCATE);
+
+	RegisterTagItemType("Handoff indicator", TAG_ITEM_DEHIGHLIGHT);
+	RegisterTagItemFunction("Toggle handoff indicator", TAG_FUNC_DEHIGHLIGHT);
+
+	RegisterTagItemType("Pressure setting", TAG_ITEM_PRESSURE);
+	RegisterTagItemFunction("Update pressure setting", TAG_FUNC_PRESSURE_UPDATE);
+	RegisterTagItemFunction("Reset pressure setting", TAG_FUNC_PRESSURE_RESET);
+
+	RegisterTagItemType("Closed area incursion", TAG_ITEM_CLOSED);
+
+	RegisterTagItemType("Taxi route", TAG_ITEM_ROUTE);
+	RegisterTagItemFunction("Assign taxi route", TAG_FUNC_ROUTE);
+	RegisterTagItemType("Current taxiway", TAG_ITEM_TAXIWAY);
+	RegisterTagItemFunction("Edit taxi route", TAG_FUNC_ROUTE_EDIT);
+	RegisterTagItemType("Taxi route conformance", TAG_ITEM_CONFORMANCE);
+	RegisterTagItemFunction("Stop bars", TAG_FUNC_STOP_BAR);
+	RegisterTagItemType("Landing sequence", TAG_ITEM_SEQUENCE);
+	RegisterTagItemType("Departure queue position", TAG_ITEM_QUEUE);
+
+	pressure_due_list = RegisterFpList("Pressure due");
+	if (!pressure_due_list.GetColumnNumber()) {
+		pressure_due_list.AddColumnDefinition("C/S", 8, false, nullptr, EuroScope::TAG_ITEM_TYPE_CALLSIGN, nullptr, EuroScope::TAG_ITEM_FUNCTION_NO, nullptr, EuroScope::TAG_ITEM_FUNCTION_NO);
+		pressure_due_list.AddColumnDefinition("QNH", 3, true, PLUGIN_NAME, TAG_ITEM_PRESSURE, nullptr, EuroScope::TAG_ITEM_FUNCTION_NO, nullptr, EuroScope::TAG_ITEM_FUNCTION_NO);
+	}
+
+	for (auto fp = FlightPlanSelectFirst(); fp.IsValid(); fp = FlightPlanSelectNext(fp)) {
+		auto ac = aircraft(fp.GetCallsign());
+
+		set_origin(ac, fp.GetFlightPlanData().GetOrigin());
+		set_ground_state(ac, decode_ground_state(fp.GetGroundState()));
+		ac_scratchpad[ac] = fp.GetControllerAssignedData().GetScratchPadString();
+		set_position(ac, fp.GetFPTrackPosition().GetPosition());
+	}
+
+	// dehighlights are dropped as ground states change; this only catches
+	// anything missed, e.g. when the plugin was loaded mid-session
+	timers.schedule("dehighlight", DEHIGHLIGHT_CHECK_INTERVAL, [this] {
+		for (std::uint32_t ac = 0; ac < callsigns.capacity(); ac++) {
+			if (!(ac_flags[ac] & AC_DEHIGHLIGHT)) continue;
+
+			auto fp = FlightPlanSelect(callsigns.name(ac).c_str());
+			set_ground_state(ac, fp.IsValid() ? decode_ground_state(fp.GetGroundState()) : GS_NONE);
+		}
+	});
+
+	timers.schedule("conflicts", 1, [this] { check_conflicts(); });
+
+	// radar targets with no flight plan are never disconnected, so their
+	// handles are released once they stop being updated
+	timers.schedule("targets", TARGET_CHECK_INTERVAL, [this] {
+		for (std::uint32_t ac = 0; ac < callsigns.capacity(); ac++) {
+			if (callsigns.name(ac).empty() || timers.time() - ac_seen[ac] < TARGET_TIMEOUT) continue;
+			if (!FlightPlanSelect(callsigns.name(ac).c_str()).IsValid()) release(ac);
+		}
+	});
+
+	load();
+}
+
+std::uint32_t Plugin::aircraft(const char *callsign) {
+	auto ac = callsigns.intern(callsign);
+
+	if (ac >= ac_flags.size()) {
+		ac_flags.resize(ac + 1);
+		ac_pressure.resize(ac + 1);
+		ac_origin.resize(ac + 1);
+		ac_scratchpad.resize(ac + 1);
+		ac_ground_state.resize(ac + 1);
+		ac_position.resize(ac + 1);
+		ac_aerodrome.resize(ac + 1, UINT32_MAX);
+		ac_local.resize(ac + 1);
+		ac_gs.resize(ac + 1);
+		ac_altitude.resize(ac + 1);
+		ac_track.resize(ac + 1);
+		ac_closed.resize(ac + 1, UINT32_MAX);
+		ac_runway.resize(ac + 1, UINT32_MAX);
+		ac_final.resize(ac + 1, UINT32_MAX);
+		trails.resize(ac + 1);
+		ac_stand.resize(ac + 1, { nullptr, UINT32_MAX });
+		ac_assigned.resize(ac + 1, { nullptr, UINT32_MAX });
+		ac_route.resize(ac + 1);
+		ac_edge.resize(ac + 1, UINT32_MAX);
+		ac_snapped.resize(ac + 1, { INFINITY, INFINITY });
+		ac_seen.resize(ac + 1);
+		ac_sequence.resize(ac + 1, UINT32_MAX);
+		ac_landing.resize(ac + 1);
+		ac_eta.resize(ac + 1);
+		ac_arrival.resize(ac + 1);
+		ac_queue.resize(ac + 1, { UINT32_MAX, UINT32_MAX });
+		ac_queued.resize(ac + 1);
+	}
+
+	return ac;
+}
+
+void Plugin::release(std::uint32_t ac) {
+	set_origin(ac, nullptr);
+	set_ground_state(ac, GS_NONE);
+	pressure_due.erase(ac);
+	in_closed.erase(ac);
+	ac_closed[ac] = UINT32_MAX;
+	set_runway(ac, UINT32_MAX, UINT32_MAX);
+	trails.clear(ac);
+	set_stand(ac, nullptr, UINT32_MAX);
+	set_assigned(ac, nullptr, UINT32_MAX);
+	set_route(ac, UINT32_MAX, UINT32_MAX, UINT32_MAX);
+	set_sequence(ac, UINT32_MAX, 0);
+	ac_arrival[ac] = {};
+	set_queue(ac, UINT32_MAX, UINT32_MAX);
+
+	std::erase_if(conflicts, [ac](const auto &pair) {
+		return std::get<0>(pair) == ac || std::get<1>(pair) == ac;
+	});
+
+	ac_flags[ac] = 0;
+	ac_pressure[ac] = {};
+	ac_scratchpad[ac].clear();
+
+	// the next aircraft given this handle has no position until its first
+	// update, so must not be seen to have moved from this one's
+	ac_position[ac] = {};
+	ac_aerodrome[ac] = UINT32_MAX;
+	ac_local[ac] = {};
+	ac_edge[ac] = UINT32_MAX;
+	ac_snapped[ac] = { INFINITY, INFINITY };
+	ac_gs[ac] = ac_altitude[ac] = 0;
+	ac_track[ac] = 0;
+
+	callsigns.release(ac);
+}
+
+void Plugin::set_origin(std::uint32_t ac, const char *origin) {
+	if (!origin) origin = "";
+
+	auto &current = ac_origin[ac];
+	if (current == origin) return;
+
+	if (!current.empty()) {
+		auto it = ad_aircraft.find(current);
+		std::get<1>(*it).erase(ac);
+		if (std::get<1>(*it).empty()) ad_aircraft.erase(it);
+	}
+
+	current = origin;
+
+	if (!current.empty()) ad_aircraft[current].insert(ac);
+}
+
+void Plugin::set_position(std::uint32_t ac, const EuroScope::CPosition &posn) {
+	ac_position[ac] = posn;
+
+	auto ad = locate(posn, ac_local[ac]);
+	if (ad != ac_aerodrome[ac]) ac_edge[ac] = UINT32_MAX;
+	ac_aerodrome[ac] = ad;
+}
+
+// a bar is crossed if the segment between the last two positions crosses
+// it, which holds however far the aircraft moved between updates
+void Plugin::check_bars(std::uint32_t ac, std::uint32_t last_ad, Vec2 p) {
+	auto ad = ac_aerodrome[ac];
+	if (ad == UINT32_MAX || ad != last_ad || ac_gs[ac] > GROUND_SPEED_MAX) return;
+
+	auto &aerodrome = aerodromes[ad];
+	auto q = ac_local[ac];
+	if (p.x == q.x && p.y == q.y) return;
+
+	auto side = [](Vec2 a, Vec2 b, Vec2 c) {
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	};
+
+	// a bar spanning several cells is reported once per cell; few bars lie
+	// along one movement, so those already seen are kept in a short list,
+	// reused between updates so that none allocates
+	auto &seen = bars_seen;
+	seen.clear();
+
+	aerodrome.bar_grid.query(std::min(p.x, q.x), std::min(p.y, q.y), std::max(p.x, q.x), std::max(p.y, q.y), [&](std::uint32_t i) {
+		if (std::find(seen.cbegin(), seen.cend(), i) != seen.cend()) return;
+		seen.push_back(i);
+
+		const auto &bar = aerodrome.bars[i];
+		if (!bar.lit) return;
+
+		if ((side(p, q, bar.a) > 0) == (side(p, q, bar.b) > 0)) return;
+		if ((side(bar.a, bar.b, p) > 0) == (side(bar.a, bar.b, q) > 0)) return;
+
+		if (crossings.size() >= CROSSING_LOG_MAX) crossings.pop_front();
+		crossings.push_back({ std::time(nullptr), callsigns.name(ac), ad, i });
+
+		warn((callsigns.name(ac) + " crossed lit stop bar " + bar.name + " at " + aerodrome.name).c_str());
+	});
+}
+
+void Plugin::list_crossings() {
+	if (crossings.empty()) {
+		DisplayUserMessage(PLUGIN_NAME, "crossings", "no stop bars crossed", true, false, false, false, false);
+		return;
+	}
+
+	for (const auto &crossing : crossings) {
+		char time[16];
+		std::strftime(time, sizeof time, "%H:%M:%SZ", std::gmtime(&crossing.time));
+
+		const auto &ad = aerodromes[crossing.aerodrome];
+		auto msg = crossing.callsign + " crossed " + ad.bars[crossing.bar].name + " at " + ad.name;
+
+		DisplayUserMessage(PLUGIN_NAME, time, msg.c_str(), true, false, false, false, false);
+	}
+}
+
+// predicts touchdown as where the predicted path, one point a minute, passes
+// closest to the arrival runway's threshold, or to the aerodrome if the
+// runway is not known. the path is only walked again once it has changed,
+// and beyond SEQ_HORIZON it is cut short
+void Plugin::update_arrival(std::uint32_t ac, EuroScope::CFlightPlan fp) {
+	if (!fp.IsValid() || ac_gs[ac] <= GROUND_SPEED_MAX || fp.GetDistanceToDestination() > SEQ_RANGE) {
+		set_sequence(ac, UINT32_MAX, 0);
+		return;
+	}
+
+	auto predictions = fp.GetPositionPredictions();
+	int points = std::min(predictions.GetPointsNumber(), SEQ_HORIZON);
+	if (points < 1) {
+		set_sequence(ac, UINT32_MAX, 0);
+		return;
+	}
+
+	auto &arrival = ac_arrival[ac];
+	auto first = predictions.GetPosition(0), last = predictions.GetPosition(points - 1);
+	auto same = [](const EuroScope::CPosition &a, const EuroScope::CPosition &b) {
+		return a.m_Latitude == b.m_Latitude && a.m_Longitude == b.m_Longitude;
+	};
+
+	if (arrival.points == points && same(arrival.first, first) && same(arrival.last, last)) {
+		set_sequence(ac, arrival.sequence, arrival.eta);
+		return;
+	}
+
+	arrival = { points, first, last, UINT32_MAX, 0 };
+
+	std::string dest = fp.GetFlightPlanData().GetDestination();
+	auto it = std::find_if(aerodromes.begin(), aerodromes.end(), [&](const auto &ad) { return ad.name == dest; });
+	if (it == aerodromes.end()) {
+		set_sequence(ac, UINT32_MAX, 0);
+		return;
+	}
+
+	std::uint32_t ad = it - aerodromes.begin();
+	std::string rwy = fp.GetFlightPlanData().GetArrivalRwy();
+
+	Vec2 threshold = { 0, 0 };
+	for (auto i : it->runways) {
+		const auto &runway = runways[i];
+
+		if (runway.name[0] == rwy) threshold = runway.start;
+		else if (runway.name[1] == rwy)
+			threshold = { runway.start.x + runway.length * runway.ux, runway.start.y + runway.length * runway.uy };
+	}
+
+	Vec2 path[SEQ_HORIZON];
+	for (int i = 0; i < points; i++) path[i] = it->frame.project(predictions.GetPosition(i));
+
+	float minutes = 0, best = INFINITY;
+	for (int i = 0; i + 1 < points; i++) {
+		Vec2 a = path[i], b = path[i + 1];
+		float dx = b.x - a.x, dy = b.y - a.y, len2 = dx * dx + dy * dy;
+
+		float t = len2 > 0 ? std::clamp(((threshold.x - a.x) * dx + (threshold.y - a.y) * dy) / len2, 0.0f, 1.0f) : 0;
+		float dist = std::hypot(a.x + t * dx - threshold.x, a.y + t * dy - threshold.y);
+
+		if (dist < best) {
+			best = dist;
+			minutes = i + t;
+		}
+	}
+
+	auto seq = std::find_if(sequences.begin(), sequences.end(), [&](const auto &sequence) {
+		return sequence.aerodrome == ad && sequence.runway == rwy;
+	});
+	if (seq == sequences.end()) seq = sequences.insert(seq, { ad, rwy, {} });
+
+	arrival.sequence = seq - sequences.begin();
+	arrival.eta = std::time(nullptr) + 60.0 * minutes;
+	set_sequence(ac, arrival.sequence, arrival.eta);
+}
+
+// reorders only the runway whose arrival moved, and only once the predicted
+// touchdown changes by more than SEQ_ETA_STEP
+void Plugin::set_sequence(std::uint32_t ac, std::uint32_t seq, double eta) {
+	auto old = ac_sequence[ac];
+	if (old == seq && (seq == UINT32_MAX || std::abs(eta - ac_eta[ac]) < SEQ_ETA_STEP)) return;
+
+	auto renumber = [this](std::vector<std::uint32_t> &arrivals) {
+		for (std::uint32_t i = 0; i < arrivals.size(); i++) ac_landing[arrivals[i]] = i + 1;
+	};
+
+	if (old != seq && old != UINT32_MAX) {
+		auto &arrivals = sequences[old].arrivals;
+		arrivals.erase(std::find(arrivals.begin(), arrivals.end(), ac));
+		renumber(arrivals);
+	}
+
+	ac_sequence[ac] = seq;
+	ac_eta[ac] = eta;
+	ac_landing[ac] = 0;
+
+	if (seq == UINT32_MAX) return;
+
+	auto &arrivals = sequences[seq].arrivals;
+	if (old != seq) arrivals.push_back(ac);
+
+	std::sort(arrivals.begin(), arrivals.end(), [this](std::uint32_t a, std::uint32_t b) {
+		return ac_eta[a] < ac_eta[b];
+	});
+	renumber(arrivals);
+}
+
+// aircraft join a queue when slow inside its area, and stay in it however
+// they move up until they leave the area
+void Plugin::update_queue(std::uint32_t ac) {
+	auto [ad, queue] = ac_queue[ac];
+	const auto &posn = ac_local[ac];
+
+	if (queue != UINT32_MAX) {
+		auto &area = aerodromes[ad].queues[queue];
+		if (ad == ac_aerodrome[ac] && area.area.contains(posn)) return;
+
+		double wait = std::difftime(std::time(nullptr), ac_queued[ac]);
+		area.waits++;
+		area.total_wait += wait;
+		area.wait_p90.push(wait);
+
+		set_queue(ac, UINT32_MAX, UINT32_MAX);
+	}
+
+	ad = ac_aerodrome[ac];
+	if (ad == UINT32_MAX || ac_gs[ac] > QUEUE_SPEED) return;
+
+	const auto &aerodrome = aerodromes[ad];
+	queue = UINT32_MAX;
+
+	aerodrome.queue_grid.query(posn.x, posn.y, posn.x, posn.y, [&](std::uint32_t i) {
+		if (queue == UINT32_MAX && aerodrome.queues[i].area.contains(posn)) queue = i;
+	});
+
+	if (queue != UINT32_MAX) set_queue(ac, ad, queue);
+}
+
+void Plugin::set_queue(std::uint32_t ac, std::uint32_t ad, std::uint32_t queue) {
+	auto [old_ad, old] = ac_queue[ac];
+	if (old_ad == ad && old == queue) return;
+
+	if (old != UINT32_MAX) std::erase(aerodromes[old_ad].queues[old].aircraft, ac);
+
+	ac_queue[ac] = { ad, queue };
+	if (queue == UINT32_MAX) return;
+
+	ac_queued[ac] = std::time(nullptr);
+	aerodromes[ad].queues[queue].aircraft.push_back(ac);
+}
+
+// nearest aerodrome within FRAME_RANGE, and the position in its frame
+std::uint32_t Plugin::locate(const EuroScope::CPosition &posn, Vec2 &local) const {
+	double reach = FRAME_RANGE / EARTH_RADIUS;
+	double lat = posn.m_Latitude * std::numbers::pi / 180.0, lon = posn.m_Longitude * std::numbers::pi / 180.0;
+
+	std::uint32_t nearest = UINT32_MAX;
+	float nearest_dist = FRAME_RANGE;
+
+	for (std::uint32_t i = 0; i < aerodromes.size(); i++) {
+		const auto &frame = aerodromes[i].frame;
+
+		// the projection folds the far side of the earth onto the near
+		// side, so anything not close by angle is ruled out first
+		if (std::abs(lat - frame.lat0) > reach) continue;
+		if (std::abs(std::remainder(lon - frame.lon0, 2 * std::numbers::pi)) * frame.cos_lat0 > reach) continue;
+
+		auto v = frame.project(posn);
+		float dist = std::hypot(v.x, v.y);
+		if (dist < nearest_dist) {
+			nearest = i;
+			nearest_dist = dist;
+			local = v;
+		}
+	}
+
+	return nearest;
+}
+
+void Plugin::set_pressure_due(EuroScope::CFlightPlan fp, std::uint32_t ac, bool due) {
+	if (due == pressure_due.contains(ac)) return;
+
+	if (due) {
+		pressure_due.insert(ac);
+		if (fp.IsValid()) pressure_due_list.AddFpToTheList(fp);
+	} else {
+		pressure_due.erase(ac);
+		if (fp.IsValid()) pressure_due_list.RemoveFpFromTheList(fp);
+	}
+}
+
+void Plugin::set_ground_state(std::uint32_t ac, GroundState state) {
+	if (state != GS_TAXI) ac_flags[ac] &= ~(AC_DEHIGHLIGHT | AC_WARN);
+
+	auto &current = ac_ground_state[ac];
+	if (current == state) return;
+
+	ground_state_set[current].erase(ac);
+	ground_state_set[state].insert(ac);
+	current = state;
+}
+
+void Plugin::update_warn(std::uint32_t ac) {
+	ac_flags[ac] &= ~AC_WARN;
+	if (ac_ground_state[ac] != GS_TAXI) return;
+
+	// a hotspot named in the scratchpad warns within WARN_DIST of it, as it
+	// always has, even away from the aerodromes whose hotspots are swept
+	auto it = hotspot_by_name.find(ac_scratchpad[ac]);
+	if (it != hotspot_by_name.cend() && std::get<1>(*it)->position.DistanceTo(ac_position[ac]) * METRES_PER_NM <= WARN_DIST) {
+		ac_flags[ac] |= AC_WARN;
+		return;
+	}
+
+	auto ad = ac_aerodrome[ac];
+	if (ad == UINT32_MAX) return;
+
+	// sweep the track ahead for as far as the aircraft will taxi within the
+	// lookahead time, and warn if it passes within WARN_DIST of any hotspot;
+	// only the cells around the sweep are tested, each as one batch
+	float track = ac_track[ac] * std::numbers::pi / 180.0;
+	float ahead = ac_gs[ac] * KNOT * options.warn_lookahead;
+	Vec2 start = ac_local[ac], dir = { std::sin(track), std::cos(track) };
+	Vec2 end = { start.x + dir.x * ahead, start.y + dir.y * ahead };
+
+	bool near = false;
+	aerodromes[ad].hotspots.query(
+		std::min(start.x, end.x) - WARN_DIST, std::min(start.y, end.y) - WARN_DIST,
+		std::max(start.x, end.x) + WARN_DIST, std::max(start.y, end.y) + WARN_DIST,
+		[&](const Vec2 *points, size_t n) {
+			if (!near) near = kernels::count_near(points, n, start, dir, ahead, WARN_DIST);
+		}
+	);
+
+	if (near)
+		ac_flags[ac] |= AC_WARN;
+}
+
+void Plugin::update_closed(std::uint32_t ac) {
+	const auto &posn = ac_local[ac];
+	auto ad = ac_aerodrome[ac];
+	auto &last = ac_closed[ac];
+
+	if (ac_gs[ac] > GROUND_SPEED_MAX || ad == UINT32_MAX) {
+		last = UINT32_MAX;
+	} else if (last == UINT32_MAX || closed[last].aerodrome != ad || !closed[last].contains(posn)) {
+		last = UINT32_MAX;
+
+		aerodromes[ad].closed.query(posn.x, posn.y, posn.x, posn.y, [&](std::uint32_t id) {
+			if (last == UINT32_MAX && closed[id].contains(posn)) last = id;
+		});
+	}
+
+	if (last == UINT32_MAX) in_closed.erase(ac);
+	else in_closed.insert(ac);
+}
+
+void Plugin::update_runway(std::uint32_t ac) {
+	auto ad = ac_aerodrome[ac];
+	if (ad == UINT32_MAX) {
+		set_runway(ac, UINT32_MAX, UINT32_MAX);
+		return;
+	}
+
+	const auto &posn = ac_local[ac];
+	bool ground = ac_gs[ac] <= GROUND_SPEED_MAX;
+
+	float track = ac_track[ac] * std::numbers::pi / 180.0;
+	float tx = std::sin(track), ty = std::cos(track);
+	float aligned = std::cos(APPROACH_MAX_ANGLE * std::numbers::pi / 180.0);
+
+	// of the runway ends ahead, the one the aircraft will reach first
+	std::uint32_t on = UINT32_MAX, final = UINT32_MAX;
+	double final_time = options.final_alert;
+
+	for (auto i : aerodromes[ad].runways) {
+		if (on != UINT32_MAX) break;
+
+		const auto &rwy = runways[i];
+		float x = posn.x - rwy.start.x, y = posn.y - rwy.start.y;
+
+		float along = x * rwy.ux + y * rwy.uy;
+		float across = std::abs(y * rwy.ux - x * rwy.uy);
+
+		if (along >= 0 && along <= rwy.length) {
+			if (across > RUNWAY_HALF_WIDTH) continue;
+
+			// fast traffic over the strip only occupies the runway if it
+			// came from final or started its roll on it; this ignores
+			// overflights
+			if (ground || ac_runway[ac] == i || ac_final[ac] == i) on = i;
+		} else if (!ground && ac_altitude[ac] <= options.approach_ceiling) {
+			if (across > APPROACH_HALF_WIDTH) continue;
+
+			float heading = tx * rwy.ux + ty * rwy.uy;
+			float dist = along < 0 ? -along : along - rwy.length;
+			if (dist > APPROACH_LENGTH || (along < 0 ? heading : -heading) < aligned) continue;
+
+			double time = dist / (ac_gs[ac] * KNOT);
+			if (time <= final_time) {
+				final = i;
+				final_time = time;
+			}
+		}
+	}
+
+	set_runway(ac, on, final);
+
+	// a runway shared by several aircraft is checked on every update, as
+	// one starting its roll changes nothing that set_runway sees
+	if (on != UINT32_MAX && runways[on].occupants.size() > 1) check_runway(on);
+}
+
+void Plugin::set_runway(std::uint32_t ac, std::uint32_t on, std::uint32_t final) {
+	auto move = [this, ac](std::uint32_t &current, std::uint32_t next, auto member) {
+		if (current == next) return;
+
+		std::uint32_t previous = current;
+		current = next;
+
+		if (previous != UINT32_MAX) {
+			auto &list = runways[previous].*member;
+			list.erase(std::find(list.begin(), list.end(), ac));
+			check_runway(previous);
+		}
+
+		if (next != UINT32_MAX) {
+			(runways[next].*member).push_back(ac);
+			check_runway(next);
+		}
+	};
+
+	move(ac_runway[ac], on, &Runway::occupants);
+	move(ac_final[ac], final, &Runway::finals);
+}
+
+void Plugin::check_runway(std::uint32_t i) {
+	auto &rwy = runways[i];
+
+	bool rolling = false;
+	for (auto ac : rwy.occupants) rolling |= ac_gs[ac] > RUNWAY_ROLL_SPEED;
+
+	bool conflict = !rwy.occupants.empty() && (!rwy.finals.empty() || (rolling && rwy.occupants.size() > 1));
+
+	if (conflict && !rwy.conflict) {
+		std::string msg = aerodromes[rwy.aerodrome].name + " " + rwy.name[0] + "/" + rwy.name[1] + " occupied by";
+		for (auto ac : rwy.occupants) msg += " " + callsigns.name(ac);
+
+		if (!rwy.finals.empty()) {
+			msg += ", on final";
+			for (auto ac : rwy.finals) msg += " " + callsigns.name(ac);
+		}
+
+		DisplayUserMessage(PLUGIN_NAME, "Runway", msg.c_str(), true, true, true, true, false);
+	}
+
+	rwy.conflict = conflict;
+}
+
+void Plugin::check_conflicts() {
+	conflicts.clear();
+
+	std::vector<std::uint32_t> ground;
+
+	for (std::uint32_t ac = 0; ac < callsigns.capacity(); ac++) {
+		if (callsigns.name(ac).empty() || ac_gs[ac] > GROUND_SPEED_MAX) continue;
+		if (ac_aerodrome[ac] == UINT32_MAX) continue;
+
+		ground.push_back(ac);
+	}
+
+	// each aircraft is put in the cells of the box around the segment it
+	// will taxi along within the horizon, inflated by half the alert radius,
+	// so the boxes of any conflicting pair overlap and share a cell. cells
+	// span the radius, so crowded areas don't put every aircraft in one cell.
+	// aircraft in different frames may share cells, and are told apart below
+	float radius = options.conflict_radius * METRES_PER_NM;
+	float horizon = options.conflict_horizon;
+	if (radius <= 0) return;
+
+	std::vector<std::array<float, 4>> boxes(ground.size());
+	SpatialGrid grid(radius);
+
+	for (std::uint32_t i = 0; i < ground.size(); i++) {
+		auto ac = ground[i];
+		const auto &posn = ac_local[ac];
+
+		float track = ac_track[ac] * std::numbers::pi / 180.0;
+		float ahead = ac_gs[ac] * KNOT * std::max(horizon, 0.0f);
+		Vec2 end = { posn.x + std::sin(track) * ahead, posn.y + std::cos(track) * ahead };
+
+		boxes[i] = {
+			std::min(posn.x, end.x) - radius / 2, std::min(posn.y, end.y) - radius / 2,
+			std::max(posn.x, end.x) + radius / 2, std::max(posn.y, end.y) + radius / 2,
+		};
+
+		grid.insert(boxes[i][0], boxes[i][1], boxes[i][2], boxes[i][3], i);
+	}
+
+	// a pair sharing several cells is found once per cell
+	std::vector<std::uint32_t> seen(ground.size(), UINT32_MAX);
+
+	for (std::uint32_t i = 0; i < ground.size(); i++) {
+		auto a = ground[i];
+		const auto &posn = ac_local[a];
+		const auto &box = boxes[i];
+
+		grid.query(box[0], box[1], box[2], box[3], [&](std::uint32_t j) {
+			if (j <= i || seen[j] == i) return;
+			seen[j] = i;
+
+			auto b = ground[j];
+			if (ac_aerodrome[a] != ac_aerodrome[b]) return;
+			if (ac_gs[a] < STATIONARY_SPEED && ac_gs[b] < STATIONARY_SPEED) return;
+
+			float dx = ac_local[b].x - posn.x, dy = ac_local[b].y - posn.y;
+
+			// closest approach within the horizon, both holding track and speed
+			float ta = ac_track[a] * std::numbers::pi / 180.0, tb = ac_track[b] * std::numbers::pi / 180.0;
+			float vx = (ac_gs[b] * std::sin(tb) - ac_gs[a] * std::sin(ta)) * KNOT;
+			float vy = (ac_gs[b] * std::cos(tb) - ac_gs[a] * std::cos(ta)) * KNOT;
+
+			float vv = vx * vx + vy * vy;
+			float t = vv > 0 ? std::clamp(-(dx * vx + dy * vy) / vv, 0.0f, horizon) : 0;
+
+			if (std::hypot(dx + vx * t, dy + vy * t) < radius)
+				conflicts.emplace_back(a, b);
+		});
+	}
+}
+
+void Plugin::update_stand(std::uint32_t ac) {
+	const auto &posn = ac_local[ac];
+	auto ad = ac_aerodrome[ac];
+
+	if (ac_gs[ac] >= STATIONARY_SPEED || ad == UINT32_MAX) {
+		set_stand(ac, nullptr, UINT32_MAX);
+		ac_snapped[ac] = { INFINITY, INFINITY };
+		return;
+	}
+
+	// stationary aircraft are only searched again once they have moved
+	if (std::hypot(posn.x - ac_snapped[ac].x, posn.y - ac_snapped[ac].y) < STAND_MOVE_DIST) return;
+
+	ac_snapped[ac] = posn;
+
+	auto *index = aerodromes[ad].stands;
+	std::uint32_t nearest = UINT32_MAX;
+	float nearest_dist = STAND_SNAP_DIST;
+
+	if (index) index->grid.query(
+		posn.x - STAND_SNAP_DIST, posn.y - STAND_SNAP_DIST,
+		posn.x + STAND_SNAP_DIST, posn.y + STAND_SNAP_DIST,
+		[&](std::uint32_t i) {
+			float dist = std::hypot(index->positions[i].x - posn.x, index->positions[i].y - posn.y);
+			if (dist < nearest_dist) {
+				nearest = i;
+				nearest_dist = dist;
+			}
+		}
+	);
+
+	set_stand(ac, nearest == UINT32_MAX ? nullptr : index, nearest);
+}
+
+void Plugin::set_stand(std::uint32_t ac, StandIndex *index, std::uint32_t i) {
+	auto &[current, current_i] = ac_stand[ac];
+	if (current == index && current_i == i) return;
+
+	auto [last, last_i] = ac_stand[ac];
+
+	current = index;
+	current_i = i;
+
+	if (current) {
+		if (!current->occupants[current_i]++) current->occupied.insert(current_i);
+		current->occupant[current_i] = ac;
+	}
+
+	if (!last) return;
+
+	// the occupant shown is the latest to arrive; when it leaves a stand
+	// still shared, another aircraft there is found to show instead
+	auto &occupant = last->occupant[last_i];
+
+	if (!--last->occupants[last_i]) {
+		last->occupied.erase(last_i);
+		occupant = UINT32_MAX;
+	} else if (occupant == ac) {
+		for (std::uint32_t other = 0; other < ac_stand.size(); other++) {
+			if (std::get<0>(ac_stand[other]) == last && std::get<1>(ac_stand[other]) == last_i) {
+				occupant = other;
+				break;
+			}
+		}
+	}
+}
+
+void Plugin::update_assigned(std::uint32_t ac, EuroScope::CFlightPlan fp) {
+	auto data = fp.GetFlightPlanData();
+	const char *name = fp.GetControllerAssignedData().GetFlightStripAnnotation(3);
+
+	// the annotation names a stand at the origin until the aircraft has
+	// left, then one at the destination
+	std::string ad = fp.GetDistanceFromOrigin() > STAND_ORIGIN_DIST ? data.GetDestination() : data.GetOrigin();
+
+	StandIndex *index = nullptr;
+	std::uint32_t i = UINT32_MAX;
+
+	auto it1 = stands.find(ad);
+	if (*name && it1 != stands.cend()) {
+		auto it2 = std::get<1>(*it1).find(name);
+		if (it2 != std::get<1>(*it1).cend() && std::get<1>(*it2).index != UINT32_MAX) {
+			index = &stand_index[ad];
+			i = std::get<1>(*it2).index;
+		}
+	}
+
+	set_assigned(ac, index, i);
+}
+
+void Plugin::set_assigned(std::uint32_t ac, StandIndex *index, std::uint32_t i) {
+	auto &[current, current_i] = ac_assigned[ac];
+	if (current == index && current_i == i) return;
+
+	if (current && !--current->assignments[current_i]) current->assigned.erase(current_i);
+
+	current = index;
+	current_i = i;
+
+	if (current && !current->assignments[current_i]++) current->assigned.insert(current_i);
+}
+
+void Plugin::allocate_stand(EuroScope::CFlightPlan fp, RECT area) {
+	auto ac = aircraft(fp.GetCallsign());
+	auto data = fp.GetFlightPlanData();
+
+	bool departing = fp.GetDistanceFromOrigin() <= STAND_ORIGIN_DIST;
+	std::string ad = departing ? data.GetOrigin() : data.GetDestination();
+
+	auto it = stand_index.find(ad);
+	if (it == stand_index.cend() || std::get<1>(*it).aerodrome == UINT32_MAX) return;
+	auto &index = std::get<1>(*it);
+
+	char engine_type = data.GetEngineType();
+	bool prop = engine_type == 'P' || engine_type == 'T';
+	const auto &letter = prop ? index.prop_letter : index.letter;
+
+	// the aircraft's size code rules out stands by both their size and their
+	// letter, and a stand already assigned narrows the search to its category
+	int code = size_code(data.GetAircraftWtc());
+	const auto &takes = (prop ? index.prop_takes : index.takes)[code];
+
+	const IndexSet *category = nullptr;
+	auto [own, own_i] = ac_assigned[ac];
+	if (own == &index) category = &(prop ? index.prop_category : index.category)[letter[own_i]];
+
+	// stands taken only by this aircraft are still offered
+	auto own_bit = [&](const std::pair<StandIndex *, std::uint32_t> &stand, size_t w) -> std::uint64_t {
+		auto [at, i] = stand;
+		return at == &index && i / 64 == w ? (std::uint64_t) 1 << (i % 64) : 0;
+	};
+
+	const auto &fits = index.fits[code];
+	bool shared = own == &index && index.assignments[own_i] > 1;
+	auto [here, here_i] = ac_stand[ac];
+	bool occupied_shared = here == &index && index.occupants[here_i] > 1;
+
+	// arrivals are ranked from the exit of the landing runway, anything else
+	// from where the aircraft is
+	Vec2 from = ac_local[ac];
+
+	if (!departing) {
+		const Runway *landing = nullptr;
+		int end = 0;
+
+		for (auto i : aerodromes[index.aerodrome].runways) {
+			const auto &rwy = runways[i];
+			if (!landing) landing = &rwy;
+
+			for (int j = 0; j < 2; j++) {
+				if (rwy.name[j] == data.GetArrivalRwy()) {
+					landing = &rwy;
+					end = j;
+				}
+			}
+		}
+
+		if (landing) {
+			float along = landing->length * (end ? 1 - RUNWAY_EXIT_FRACTION : RUNWAY_EXIT_FRACTION);
+			from = { landing->start.x + along * landing->ux, landing->start.y + along * landing->uy };
+		}
+	}
+
+	std::vector<std::pair<float, std::uint32_t>> candidates;
+
+	for (size_t w = 0; w < fits.word_count(); w++) {
+		auto occupied = index.occupied.word(w) & ~(occupied_shared ? 0 : own_bit(ac_stand[ac], w));
+		auto assigned = index.assigned.word(w) & ~(shared ? 0 : own_bit(ac_assigned[ac], w));
+
+		auto word = fits.word(w) & takes.word(w) & ~occupied & ~assigned;
+		if (category) word &= category->word(w);
+
+		for (; word; word &= word - 1) {
+			auto i = (std::uint32_t) (w * 64 + std::countr_zero(word));
+
+			candidates.emplace_back(std::hypot(index.positions[i].x - from.x, index.positions[i].y - from.y), i);
+		}
+	}
+
+	auto last = candidates.begin() + std::min<size_t>(candidates.size(), STAND_POPUP_MAX);
+	std::partial_sort(candidates.begin(), last, candidates.end());
+
+	OpenPopupList(area, "Stand", 2);
+
+	for (auto it = candidates.begin(); it != last; it++) {
+		auto i = std::get<1>(*it);
+		char info[4] = { letter[i], ' ', index.size[i], 0 };
+
+		AddPopupListElement(index.names[i].c_str(), info, TAG_FUNC_STAND_SELECT, own == &index && own_i == i);
+	}
+
+	if (candidates.empty())
+		AddPopupListElement("None free", "", TAG_FUNC_STAND_SELECT, false, EuroScope::POPUP_ELEMENT_NO_CHECKBOX, true);
+}
+
+// closes the edges on closed taxiways or inside closed areas, then reroutes
+// every aircraft from where its route started
+void Plugin::update_closures() {
+	for (auto &ad : aerodromes) {
+		auto &graph = ad.taxi;
+		std::vector<std::uint8_t> blocked(graph.edges.size());
+
+		for (std::uint32_t e = 0; e < graph.edges.size(); e++) {
+			const auto &edge = graph.edges[e];
+			if (edge.taxiway != UINT32_MAX && closed_taxiways.contains(graph.taxiways[edge.taxiway])) blocked[e] = 1;
+
+			const auto &a = graph.nodes[edge.a], &b = graph.nodes[edge.b];
+			Vec2 mid = { (a.x + b.x) / 2, (a.y + b.y) / 2 };
+
+			ad.closed.query(mid.x, mid.y, mid.x, mid.y, [&](std::uint32_t id) {
+				if (closed[id].contains(mid)) blocked[e] = 1;
+			});
+		}
+
+		graph.block(std::move(blocked));
+	}
+
+	// typed routes are the controller's, so are only checked; others are
+	// routed again from the start of the edge the aircraft is expected on.
+	// a route that cannot avoid the closures is kept, marked as blocked
+	routed.for_each([this](std::uint32_t ac) {
+		const auto &route = ac_route[ac];
+		auto &aerodrome = aerodromes[route.aerodrome];
+		auto &graph = aerodrome.taxi;
+
+		bool ok;
+		if (route.typed) {
+			ok = std::none_of(route.edges.begin() + route.next, route.edges.end(), [&](std::uint32_t e) { return graph.is_blocked(e); });
+		} else {
+			auto from = route.nodes[route.next];
+			auto edges = graph.route(from, aerodrome.holds[route.hold].node);
+
+			ok = edges != nullptr;
+			if (ok) assign_route(ac, route.aerodrome, from, route.hold, *edges);
+		}
+
+		if (ok) {
+			ac_flags[ac] &= ~AC_BLOCKED;
+		} else {
+			ac_flags[ac] |= AC_BLOCKED;
+			warn(("taxi route for " + callsigns.name(ac) + " crosses a closure").c_str());
+		}
+	});
+}
+
+// matches the aircraft to the taxiway edge it is on, scoring edges by
+// distance plus how far they are from its track; it stays on its edge or
+// moves to one sharing a node with it, and the whole neighbourhood is only
+// searched once it has left them all
+void Plugin::update_taxiway(std::uint32_t ac) {
+	auto ad = ac_aerodrome[ac];
+	auto &current = ac_edge[ac];
+
+	if (ad == UINT32_MAX || ac_gs[ac] > GROUND_SPEED_MAX) {
+		current = UINT32_MAX;
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	const auto &graph = aerodromes[ad].taxi;
+	const auto &posn = ac_local[ac];
+
+	bool moving = ac_gs[ac] >= STATIONARY_SPEED;
+	float track = ac_track[ac] * std::numbers::pi / 180.0;
+	float tx = std::sin(track), ty = std::cos(track);
+
+	auto score = [&](std::uint32_t e) {
+		float along, dist = graph.distance(e, posn, along);
+		if (dist > MATCH_DIST) return INFINITY;
+		if (!moving) return dist;
+
+		const auto &edge = graph.edges[e];
+		const auto &a = graph.nodes[edge.a], &b = graph.nodes[edge.b];
+		float aligned = std::abs((b.x - a.x) * tx + (b.y - a.y) * ty) / edge.length;
+
+		return dist + MATCH_HEADING_WEIGHT * (1 - aligned);
+	};
+
+	std::uint32_t best = UINT32_MAX;
+	float best_score = INFINITY;
+
+	auto consider = [&](std::uint32_t e) {
+		float s = score(e);
+		if (s < best_score) {
+			best = e;
+			best_score = s;
+		}
+	};
+
+	if (current != UINT32_MAX) {
+		float current_score = score(current);
+
+		for (auto n : { graph.edges[current].a, graph.edges[current].b })
+			for (auto e : graph.adjacent[n]) consider(e);
+
+		if (current_score < INFINITY && current_score <= best_score + MATCH_HYSTERESIS) best = current;
+	}
+
+	if (best == UINT32_MAX) {
+		graph.edges_near(posn, MATCH_DIST, consider);
+		match_searches++;
+	}
+
+	current = best;
+
+	match_updates++;
+	match_time += std::chrono::steady_clock::now() - start;
+
+	if (routed.contains(ac)) update_conformance(ac);
+}
+
+bool Plugin::set_route(std::uint32_t ac, std::uint32_t ad, std::uint32_t from, std::uint32_t hold) {
+	if (ad == UINT32_MAX) {
+		assign_route(ac, UINT32_MAX, UINT32_MAX, UINT32_MAX, {});
+		return true;
+	}
+
+	auto edges = aerodromes[ad].taxi.route(from, aerodromes[ad].holds[hold].node);
+	if (!edges) {
+		assign_route(ac, UINT32_MAX, UINT32_MAX, UINT32_MAX, {});
+		return false;
+	}
+
+	assign_route(ac, ad, from, hold, *edges);
+	return true;
+}
+
+void Plugin::assign_route(std::uint32_t ac, std::uint32_t ad, std::uint32_t from, std::uint32_t hold, std::vector<std::uint32_t> edges) {
+	auto &route = ac_route[ac];
+	route = {};
+	routed.erase(ac);
+	ac_flags[ac] &= ~(AC_DEVIATION | AC_OVERRUN | AC_BLOCKED);
+
+	if (ad == UINT32_MAX) return;
+
+	const auto &graph = aerodromes[ad].taxi;
+
+	route.aerodrome = ad;
+	route.from = from;
+	route.hold = hold;
+	route.edges = std::move(edges);
+
+	route.nodes.push_back(from);
+	for (auto e : route.edges) route.nodes.push_back(graph.other(e, route.nodes.back()));
+
+	routed.insert(ac);
+}
+
+// follows the typed taxiways in order, joining each at the nearest point
+// where it meets the last and ending at a holding point; short connectors
+// off the named taxiways are allowed throughout
+bool Plugin::parse_route(std::uint32_t ac, const char *text) {
+	auto ad = ac_aerodrome[ac];
+	if (ad == UINT32_MAX) return false;
+
+	const auto &aerodrome = aerodromes[ad];
+	const auto &graph = aerodrome.taxi;
+
+	std::istringstream buf(text);
+	std::vector<std::string> tokens(std::istream_iterator<std::string>(buf), {});
+	if (tokens.size() < 2) return false;
+
+	auto hold = std::find_if(aerodrome.holds.begin(), aerodrome.holds.end(), [&](const auto &hold) {
+		return hold.name == tokens.back();
+	});
+	if (hold == aerodrome.holds.end()) return false;
+
+	tokens.pop_back();
+
+	std::vector<std::uint32_t> taxiways;
+	for (const auto &token : tokens) {
+		auto it = std::find(graph.taxiways.begin(), graph.taxiways.end(), token);
+		if (it == graph.taxiways.end()) return false;
+
+		taxiways.push_back(it - graph.taxiways.begin());
+	}
+
+	auto touches = [&](std::uint32_t n, std::uint32_t t) {
+		return std::any_of(graph.adjacent[n].begin(), graph.adjacent[n].end(), [&](std::uint32_t e) {
+			return graph.edges[e].taxiway == t;
+		});
+	};
+
+	auto none = [](std::uint32_t) { return 0.0f; };
+	std::vector<std::uint32_t> edges, leg;
+
+	auto from = graph.nearest(ac_local[ac], TAXI_LINK_DIST);
+	if (from == UINT32_MAX) return false;
+
+	// join the first taxiway by the shortest way from where the aircraft is
+	auto n = graph.search(from, [&](std::uint32_t n) { return touches(n, taxiways[0]); }, [&](std::uint32_t e) {
+		return !graph.is_blocked(e);
+	}, none, leg);
+	if (n == UINT32_MAX) return false;
+
+	edges.insert(edges.end(), leg.begin(), leg.end());
+
+	for (size_t i = 0; i < taxiways.size(); i++) {
+		auto t = taxiways[i];
+		bool last = i + 1 == taxiways.size();
+
+		auto goal = [&](std::uint32_t n) { return last ? n == hold->node : touches(n, taxiways[i + 1]); };
+		auto allowed = [&](std::uint32_t e) {
+			auto on = graph.edges[e].taxiway;
+			return !graph.is_blocked(e) && (on == t || on == UINT32_MAX);
+		};
+
+		n = graph.search(n, goal, allowed, none, leg);
+		if (n == UINT32_MAX) return false;
+
+		edges.insert(edges.end(), leg.begin(), leg.end());
+	}
+
+	assign_route(ac, ad, from, hold - aerodrome.holds.begin(), std::move(edges));
+	ac_route[ac].typed = true;
+
+	return true;
+}
+
+std::string Plugin::route_text(const TaxiRoute &route) const {
+	const auto &ad = aerodromes[route.aerodrome];
+
+	std::string text;
+	std::uint32_t last = UINT32_MAX;
+
+	for (auto e : route.edges) {
+		auto t = ad.taxi.edges[e].taxiway;
+		if (t == UINT32_MAX || t == last) continue;
+
+		text += ad.taxi.taxiways[t] + " ";
+		last = t;
+	}
+
+	return text + ad.holds[route.hold].name;
+}
+
+// checks the matched edge against the next few edges of the route; the
+// aircraft has deviated if it is on another edge and away from the one it
+// is expected on, and has missed the holding point if it carries on past
+// the end of the route
+void Plugin::update_conformance(std::uint32_t ac) {
+	auto &route = ac_route[ac];
+	if (route.edges.empty() || ac_aerodrome[ac] != route.aerodrome) return;
+
+	const auto &graph = aerodromes[route.aerodrome].taxi;
+	const auto &posn = ac_local[ac];
+	auto edge = ac_edge[ac];
+
+	bool on = false;
+	for (size_t i = route.next; i < std::min(route.next + ROUTE_LOOKAHEAD, route.edges.size()); i++) {
+		if (route.edges[i] == edge) {
+			route.next = i;
+			on = true;
+			break;
+		}
+	}
+
+	// off every taxiway is a deviation as much as on the wrong one, by the
+	// same distance from the edge expected
+	float along;
+	bool deviation = !on && graph.distance(route.edges[route.next], posn, along) > ROUTE_DEVIATION_DIST;
+
+	bool overrun = false;
+	if (route.next + 1 == route.edges.size() && ac_gs[ac] >= STATIONARY_SPEED) {
+		const auto &a = graph.nodes[route.nodes[route.nodes.size() - 2]], &b = graph.nodes[route.nodes.back()];
+		float length = graph.edges[route.edges.back()].length;
+
+		overrun = ((posn.x - a.x) * (b.x - a.x) + (posn.y - a.y) * (b.y - a.y)) / length > length + HOLD_OVERRUN_DIST;
+	}
+
+	if (deviation) ac_flags[ac] |= AC_DEVIATION;
+	else ac_flags[ac] &= ~AC_DEVIATION;
+
+	// a missed holding point stays flagged until the route is changed
+	if (overrun) ac_flags[ac] |= AC_OVERRUN;
+}
+
+void Plugin::warn(const char *msg) {
+	DisplayUserMessage(PLUGIN_NAME, "Warning", msg, true, false, false, true, false);
+}
+
+void Plugin::stats() {
+	using namespace std::chrono;
+
+	for (const auto &task : timers.all()) {
+		char msg[256];
+		std::snprintf(
+			msg, sizeof msg, "%llu runs, %.3f ms total, %.3f ms max",
+			(unsigned long long) task->runs,
+			duration<double, std::milli>(task->total).count(),
+			duration<double, std::milli>(task->max).count()
+		);
+
+		DisplayUserMessage(PLUGIN_NAME, task->name.c_str(), msg, true, false, false, false, false);
+	}
+
+	char msg[256];
+	std::snprintf(
+		msg, sizeof msg, "%u aircraft, %.0f positions each, %zu bytes",
+		callsigns.capacity(), options.trail_length, trails.memory()
+	);
+
+	DisplayUserMessage(PLUGIN_NAME, "trails", msg, true, false, false, false, false);
+
+	if (recorder.active()) {
+		std::snprintf(
+			msg, sizeof msg, "%llu records, %llu bytes, %llu dropped",
+			(unsigned long long) recorder.records,
+			(unsigned long long) recorder.bytes,
+			(unsigned long long) recorder.dropped
+		);
+
+		DisplayUserMessage(PLUGIN_NAME, "recorder", msg, true, false, false, false, false);
+	}
+
+	if (match_updates) {
+		std::snprintf(
+			msg, sizeof msg, "%llu updates, %.3f us each, %.1f%% searched in full",
+			(unsigned long long) match_updates,
+			duration<double, std::micro>(match_time).count() / match_updates,
+			100.0 * match_searches / match_updates
+		);
+
+		DisplayUserMessage(PLUGIN_NAME, "taxiway matching", msg, true, false, false, false, false);
+	}
+
+	for (const auto &ad : aerodromes) {
+		if (ad.taxi.edges.empty()) continue;
+
+		std::snprintf(
+			msg, sizeof msg, "%zu nodes, %zu edges, %zu routes cached, %llu hits, %llu misses",
+			ad.taxi.nodes.size(), ad.taxi.edges.size(), ad.taxi.cached(),
+			(unsigned long long) ad.taxi.hits, (unsigned long long) ad.taxi.misses
+		);
+
+		DisplayUserMessage(PLUGIN_NAME, ("taxi " + ad.name).c_str(), msg, true, false, false, false, false);
+	}
+}
+
+// starts recording, or stops if already recording and no file is given; the
+// recording starts with the sector, runways, flight plans and positions as
+// they are
+void Plugin::record(const char *path) {
+	char msg[256];
+
+	if (recorder.active()) {
+		recorder.stop();
+
+		std::snprintf(
+			msg, sizeof msg, "stopped, %llu records, %llu bytes, %llu dropped",
+			(unsigned long long) recorder.records,
+			(unsigned long long) recorder.bytes,
+			(unsigned long long) recorder.dropped
+		);
+
+		DisplayUserMessage(PLUGIN_NAME, "recorder", msg, true, false, false, false, false);
+		if (!path) return;
+	}
+
+	std::string file;
+	if (path) {
+		file = path;
+	} else {
+		file = config_path();
+		if (file.empty()) {
+			warn("cannot find where to save the recording");
+			return;
+		}
+
+		char suffix[32];
+		std::time_t now = std::time(nullptr);
+		std::strftime(suffix, sizeof suffix, "-%Y%m%d-%H%M%S.rec", std::gmtime(&now));
+
+		file.erase(file.find_last_of("."));
+		file.append(suffix);
+	}
+
+	if (!recorder.start(file)) {
+		warn(("cannot open " + file + " to record to").c_str());
+		return;
+	}
+
+	recorder.controller(ControllerMyself());
+	recorder.elements(*this);
+	recorder.runways(*this);
+
+	for (auto fp = FlightPlanSelectFirst(); fp.IsValid(); fp = FlightPlanSelectNext(fp)) {
+		recorder.flight_plan(fp);
+		recorder.assigned(fp, EuroScope::CTR_DATA_TYPE_GROUND_STATE);
+	}
+
+	for (auto rt = RadarTargetSelectFirst(); rt.IsValid(); rt = RadarTargetSelectNext(rt))
+		recorder.position(rt);
+
+	recorder.live();
+
+	DisplayUserMessage(PLUGIN_NAME, "recorder", ("recording to " + file).c_str(), true, false, false, false, false);
+}
+
+void Plugin::load() {
+	std::unordered_set<std::string> active_aerodromes;
+	StringMap<std::uint32_t> aerodrome_index;
+
+	aerodromes.clear();
+
+	for (
+		auto el = SectorFileElementSelectFirst(EuroScope::SECTOR_ELEMENT_AIRPORT);
+		el.IsValid();
+		el = SectorFileElementSelectNext(el, EuroScope::SECTOR_ELEMENT_AIRPORT)
+	) {
+		if (el.IsElementActive(false) || el.IsElementActive(true)) {
+			active_aerodromes.insert(std::string(el.GetName()));
+
+			EuroScope::CPosition pos;
+			if (!el.GetPosition(&pos, 0)) continue;
+
+			aerodrome_index[el.GetName()] = aerodromes.size();
+
+			auto &ad = aerodromes.emplace_back();
+			ad.name = el.GetName();
+			ad.frame = LocalFrame(pos);
+		}
+	}
+
+	for (std::uint32_t ac = 0; ac < callsigns.capacity(); ac++)
+		if (!callsigns.name(ac).empty()) set_position(ac, ac_position[ac]);
+
+	hotspot.clear();
+	hotspot_by_name.clear();
+	closed.clear();
+	stands.clear();
+	stand_index.clear();
+	std::fill(ac_stand.begin(), ac_stand.end(), std::pair<StandIndex *, std::uint32_t>(nullptr, UINT32_MAX));
+	std::fill(ac_assigned.begin(), ac_assigned.end(), std::pair<StandIndex *, std::uint32_t>(nullptr, UINT32_MAX));
+	std::fill(ac_snapped.begin(), ac_snapped.end(), Vec2 { INFINITY, INFINITY });
+
+	routed = {};
+	std::fill(ac_route.begin(), ac_route.end(), TaxiRoute());
+	for (auto &flags : ac_flags) flags &= ~(AC_DEVIATION | AC_OVERRUN | AC_BLOCKED);
+	crossings.clear();
+
+	sequences.clear();
+	std::fill(ac_sequence.begin(), ac_sequence.end(), UINT32_MAX);
+	std::fill(ac_landing.begin(), ac_landing.end(), 0);
+	std::fill(ac_arrival.begin(), ac_arrival.end(), Arrival());
+	std::fill(ac_queue.begin(), ac_queue.end(), std::pair<std::uint32_t, std::uint32_t>(UINT32_MAX, UINT32_MAX));
+	std::fill(ac_edge.begin(), ac_edge.end(), UINT32_MAX);
+
+	in_closed = {};
+	std::fill(ac_closed.begin(), ac_closed.end(), UINT32_MAX);
+
+	options = {};
+
+	runways.clear();
+	std::fill(ac_runway.begin(), ac_runway.end(), UINT32_MAX);
+	std::fill(ac_final.begin(), ac_final.end(), UINT32_MAX);
+
+	for (
+		auto el = SectorFileElementSelectFirst(EuroScope::SECTOR_ELEMENT_RUNWAY);
+		el.IsValid();
+		el = SectorFileElementSelectNext(el, EuroScope::SECTOR_ELEMENT_RUNWAY)
+	) {
+		if (
+			!el.IsElementActive(false, 0) && !el.IsElementActive(true, 0) &&
+			!el.IsElementActive(false, 1) && !el.IsElementActive(true, 1)
+		) continue;
+
+		EuroScope::CPosition threshold[2];
+		if (!el.GetPosition(&threshold[0], 0) || !el.GetPosition(&threshold[1], 1)) continue;
+
+		auto it = aerodrome_index.find(el.GetAirportName());
+		if (it == aerodrome_index.cend()) continue;
+
+		Runway rwy;
+		rwy.aerodrome = std::get<1>(*it);
+		rwy.name[0] = el.GetRunwayName(0);
+		rwy.name[1] = el.GetRunwayName(1);
+
+		const auto &frame = aerodromes[rwy.aerodrome].frame;
+		rwy.start = frame.project(threshold[0]);
+		auto end = frame.project(threshold[1]);
+
+		float x = end.x - rwy.start.x, y = end.y - rwy.start.y;
+
+		rwy.length = std::hypot(x, y);
+		if (rwy.length <= 0) continue;
+
+		rwy.ux = x / rwy.length;
+		rwy.uy = y / rwy.length;
+		rwy.conflict = false;
+
+		for (int i = 0; i < 4; i++) {
+			float along = i < 2 ? 0 : rwy.length;
+			float across = i == 0 || i == 3 ? -RUNWAY_HALF_WIDTH : RUNWAY_HALF_WIDTH;
+
+			rwy.corner[i] = frame.unproject({
+				rwy.start.x + along * rwy.ux + across * rwy.uy,
+				rwy.start.y + along * rwy.uy - across * rwy.ux,
+			});
+		}
+
+		aerodromes[rwy.aerodrome].runways.push_back(runways.size());
+		runways.push_back(std::move(rwy));
+	}
+
+	std::unordered_map<std::string, Hotspot> named_hotspot;
+
+	std::string path = config_path();
+	if (path.empty()) {
+		warn("cannot find the configuration file");
+		return;
+	}
+
+	std::ifstream is(path);
+	std::string line;
+	bool active = true;
+	std::uint32_t colour = 0;
+
+	decltype(stands)::mapped_type *current_stands = nullptr;
+	StandIndex *current_index = nullptr;
+	std::uint32_t current_aerodrome = UINT32_MAX;
+
+	// holding points are joined to the network once all centrelines are in
+	std::vector<std::pair<std::uint32_t, std::vector<std::string>>> pending_holds;
+
+	while (std::getline(is, line)) {
+		if (line.empty() || line[0] == ';') continue;
+
+		std::istringstream buf(line);
+		std::vector<std::string> parts(std::istream_iterator<std::string>(buf), {});
+
+		if (parts.empty() || parts[0].size() != 1) goto fail;
+		if (line[0] != 'A' && line[0] != 'O' && !active) continue;
+
+		switch (line[0]) {
+		case 'A':
+			if (parts.size() != 2) goto fail;
+
+			active = active_aerodromes.find(parts[1]) != active_aerodromes.end();
+			current_stands = &stands[parts[1]];
+			current_index = &stand_index[parts[1]];
+
+			if (auto it = aerodrome_index.find(parts[1]); it != aerodrome_index.cend()) {
+				current_aerodrome = current_index->aerodrome = std::get<1>(*it);
+				aerodromes[current_aerodrome].stands = current_index;
+			} else {
+				current_aerodrome = UINT32_MAX;
+			}
+
+			break;
+
+		case 'B': {
+			if (parts.size() != 7 || current_aerodrome == UINT32_MAX) goto fail;
+
+			auto &aerodrome = aerodromes[current_aerodrome];
+
+			StopBar bar;
+			bar.runway = std::move(parts[1]);
+			bar.name = std::move(parts[2]);
+
+			for (int i = 0; i < 2; i++) {
+				const char *lat = parts[3 + 2 * i].c_str(), *lon = parts[4 + 2 * i].c_str();
+				if (!bar.posn[i].LoadFromStrings(lon, lat)) goto fail;
+			}
+
+			bar.a = aerodrome.frame.project(bar.posn[0]);
+			bar.b = aerodrome.frame.project(bar.posn[1]);
+
+			aerodrome.bar_grid.insert(
+				std::min(bar.a.x, bar.b.x), std::min(bar.a.y, bar.b.y),
+				std::max(bar.a.x, bar.b.x), std::max(bar.a.y, bar.b.y),
+				aerodrome.bars.size()
+			);
+			aerodrome.bars.push_back(std::move(bar));
+
+			break;
+		}
+
+		case 'Q': {
+			if (parts.size() < 9 || parts.size() % 2 != 1 || current_aerodrome == UINT32_MAX) goto fail;
+
+			std::vector<EuroScope::CPosition> poly;
+			for (size_t i = 3; i < parts.size(); i += 2) {
+				const char *lat = parts[i].c_str(), *lon = parts[i + 1].c_str();
+				EuroScope::CPosition pos;
+				if (!pos.LoadFromStrings(lon, lat)) goto fail;
+
+				poly.push_back(pos);
+			}
+
+			auto &aerodrome = aerodromes[current_aerodrome];
+			aerodrome.queues.push_back({
+				std::move(parts[1]), std::move(parts[2]),
+				ClosedArea(std::move(poly), current_aerodrome, aerodrome.frame), {}
+			});
+
+			const auto &queue = aerodrome.queues.back();
+			aerodrome.queue_grid.insert(queue.area.x0, queue.area.y0, queue.area.x1, queue.area.y1, aerodrome.queues.size() - 1);
+
+			break;
+		}
+
+		case 'C': {
+			if (parts.size() % 2 != 1) goto fail;
+
+			std::vector<EuroScope::CPosition> poly;
+			for (size_t i = 1; i < parts.size(); i += 2) {
+				const char *lat = parts[i].c_str(), *lon = parts[i + 1].c_str();
+				EuroScope::CPosition pos;
+				if (!pos.LoadFromStrings(lon, lat)) goto fail;
+
+				poly.push_back(pos);
+			}
+
+			// areas away from every aerodrome are still drawn, but have no
+			// frame to be indexed in, so are never tested for incursions;
+			// nor are those of fewer than three points, which enclose nothing
+			Vec2 local;
+			auto ad = poly.size() < 3 ? UINT32_MAX : current_aerodrome != UINT32_MAX ? current_aerodrome : locate(poly[0], local);
+			if (ad == UINT32_MAX) {
+				LocalFrame frame(poly.empty() ? EuroScope::CPosition() : poly[0]);
+				closed.emplace_back(std::move(poly), ad, frame);
+				break;
+			}
+
+			const auto &area = closed.emplace_back(std::move(poly), ad, aerodromes[ad].frame);
+			aerodromes[ad].closed.insert(area.x0, area.y0, area.x1, area.y1, closed.size() - 1);
+
+			break;
+		}
+
+		case 'F':
+			if (parts.size() != 2) goto fail;
+
+			colour = std::stoll(parts[1], nullptr, 16);
+
+			break;
+
+		case 'H':
+			if (parts.size() != 3) goto fail;
+
+			named_hotspot[std::move(parts[2])] = { {}, std::move(parts[1]), colour, current_aerodrome };
+
+			break;
+
+		case 'I': {
+			if (parts.size() != 4) goto fail;
+
+			const char *lat = parts[2].c_str(), *lon = parts[3].c_str();
+			EuroScope::CPosition pos;
+			if (!pos.LoadFromStrings(lon, lat)) goto fail;
+
+			hotspot.push_back({ pos, std::move(parts[1]), colour, current_aerodrome });
+
+			break;
+		}
+
+		case 'L': {
+			if (parts.size() < 4 || parts.size() > 5 || current_aerodrome == UINT32_MAX) goto fail;
+			if (parts.size() > 4 && (parts[4].size() != 1 || parts[4][0] < 'A' || parts[4][0] >= 'A' + STAND_SIZES)) goto fail;
+
+			auto it = current_stands->find(parts[1]);
+			if (it == current_stands->end()) goto fail;
+
+			const char *lat = parts[2].c_str(), *lon = parts[3].c_str();
+			EuroScope::CPosition pos;
+			if (!pos.LoadFromStrings(lon, lat)) goto fail;
+
+			auto &stand = std::get<1>(*it);
+			if (stand.index == UINT32_MAX) {
+				stand.index = current_index->names.size();
+				current_index->names.push_back(parts[1]);
+				current_index->positions.emplace_back();
+				current_index->size.emplace_back();
+				current_index->occupant.push_back(UINT32_MAX);
+				current_index->occupants.push_back(0);
+				current_index->assignments.push_back(0);
+			}
+
+			auto local = aerodromes[current_aerodrome].frame.project(pos);
+			current_index->positions[stand.index] = local;
+			current_index->size[stand.index] = parts.size() > 4 ? parts[4][0] : 'A' + STAND_SIZES - 1;
+			current_index->grid.insert(local.x, local.y, local.x, local.y, stand.index);
+
+			break;
+		}
+
+		case 'T': {
+			if (parts.size() < 6 || parts.size() % 2 != 0 || current_aerodrome == UINT32_MAX) goto fail;
+
+			const auto &frame = aerodromes[current_aerodrome].frame;
+			std::vector<Vec2> points;
+			std::vector<EuroScope::CPosition> posns;
+
+			for (size_t i = 2; i < parts.size(); i += 2) {
+				const char *lat = parts[i].c_str(), *lon = parts[i + 1].c_str();
+				EuroScope::CPosition pos;
+				if (!pos.LoadFromStrings(lon, lat)) goto fail;
+
+				points.push_back(frame.project(pos));
+				posns.push_back(pos);
+			}
+
+			aerodromes[current_aerodrome].taxi.add(parts[1], points, posns);
+
+			break;
+		}
+
+		case 'W':
+			if (parts.size() != 5 || current_aerodrome == UINT32_MAX) goto fail;
+
+			pending_holds.emplace_back(current_aerodrome, std::move(parts));
+
+			break;
+
+		case 'O':
+			if (parts.size() != 3) goto fail;
+			if (!parse_option(options, parts[1], parts[2])) goto fail;
+
+			break;
+
+		case 'P': {
+			if (parts.size() < 3 || parts.size() > 4 || !current_stands) goto fail;
+			if (!active) continue;
+
+			auto &stand = current_stands->at(parts[1]);
+			stand.prop_letter = parts[2][0];
+			stand.prop_colour = parts.size() < 4 ? 0 : parts[3][0] - '0';
+
+			break;
+		}
+
+		case 'S': {
+			if (parts.size() < 3 || !current_stands) goto fail;
+			if (!active) continue;
+
+			StandInfo stand;
+			stand.letter = stand.prop_letter = parts[2][0];
+			stand.colour = stand.prop_colour = parts.size() < 4 ? 0 : parts[3][0] - '0';
+
+			if (parts.size() > 4) {
+				size_t offset = 0;
+				for (int i = 0; i < 4; i++) {
+					offset = line.find_first_of("\t ", offset);
+					offset = line.find_first_not_of("\t ", offset);
+				}
+
+				stand.details = std::string(line.c_str() + offset);
+			}
+
+			current_stands->insert({ parts[1], std::move(stand) });
+
+			break;
+		}
+
+		default:
+			goto fail;
+		}
+
+		continue;
+
+	fail:
+		warn("skipping invalid line in configuration file");
+	}
+
+	for (
+		auto el = SectorFileElementSelectFirst(EuroScope::SECTOR_ELEMENT_FREE_TEXT);
+		el.IsValid();
+		el = SectorFileElementSelectNext(el, EuroScope::SECTOR_ELEMENT_FREE_TEXT)
+	) {
+		decltype(named_hotspot)::iterator it;
+		if ((it = named_hotspot.find(el.GetName())) != named_hotspot.end()) {
+			EuroScope::CPosition pos;
+			if (!el.GetPosition(&pos, 0)) continue;
+
+			auto nh = std::get<1>(*it);
+			nh.position = pos;
+
+			hotspot.push_back(std::move(nh));
+		}
+	}
+
+	for (auto &[ad, parts] : pending_holds) {
+		const char *lat = parts[3].c_str(), *lon = parts[4].c_str();
+		EuroScope::CPosition pos;
+		if (!pos.LoadFromStrings(lon, lat)) {
+			warn("skipping invalid holding point in configuration file");
+			continue;
+		}
+
+		auto &aerodrome = aerodromes[ad];
+		auto node = aerodrome.taxi.link(aerodrome.frame.project(pos), pos);
+		aerodrome.holds.push_back({ std::move(parts[1]), std::move(parts[2]), node });
+	}
+
+	update_closures();
+
+	// aircraft already inside the new closed areas are flagged now rather
+	// than on their next position update
+	std::vector<std::uint8_t> inside(ac_local.size());
+
+	for (std::uint32_t i = 0; i < closed.size(); i++) {
+		const auto &area = closed[i];
+		if (area.aerodrome == UINT32_MAX) continue;
+
+		kernels::in_polygon(ac_local.data(), ac_local.size(), area.local.data(), area.local.size(), inside.data());
+
+		for (std::uint32_t ac = 0; ac < inside.size(); ac++) {
+			if (!inside[ac] || ac_aerodrome[ac] != area.aerodrome || ac_closed[ac] != UINT32_MAX) continue;
+			if (callsigns.name(ac).empty() || ac_gs[ac] > GROUND_SPEED_MAX) continue;
+
+			ac_closed[ac] = i;
+			in_closed.insert(ac);
+		}
+	}
+
+	for (auto &[ad, ad_stands] : stands) {
+		auto &index = stand_index[ad];
+		index.letter.resize(index.names.size());
+		index.prop_letter.resize(index.names.size());
+
+		for (const auto &[_, stand] : ad_stands) {
+			if (stand.index == UINT32_MAX) continue;
+
+			index.letter[stand.index] = stand.letter;
+			index.prop_letter[stand.index] = stand.prop_letter;
+			index.category[stand.letter].insert(stand.index);
+			index.prop_category[stand.prop_letter].insert(stand.index);
+
+			for (int code = 0; code <= index.size[stand.index] - 'A'; code++)
+				index.fits[code].insert(stand.index);
+
+			auto take = [&](auto &takes, char letter) {
+				int largest = letter >= 'A' && letter < 'A' + STAND_SIZES ? letter - 'A' : STAND_SIZES - 1;
+				for (int code = 0; code <= largest; code++) takes[code].insert(stand.index);
+			};
+
+			take(index.takes, stand.letter);
+			take(index.prop_takes, stand.prop_letter);
+		}
+	}
+
+	for (auto fp = FlightPlanSelectFirst(); fp.IsValid(); fp = FlightPlanSelectNext(fp))
+		update_assigned(aircraft(fp.GetCallsign()), fp);
+
+	EuroScope::CPosition centre = ControllerMyself().GetPosition();
+	double range = ControllerMyself().GetRange();
+
+	for (std::uint32_t i = 0; i < hotspot.size(); i++) {
+		auto &spot = hotspot[i];
+		if (spot.position.DistanceTo(centre) >= range) continue;
+
+		hotspot_by_name[spot.value] = &spot;
+
+		Vec2 local;
+		if (spot.aerodrome == UINT32_MAX) spot.aerodrome = locate(spot.position, local);
+		if (spot.aerodrome == UINT32_MAX) continue;
+
+		auto &ad = aerodromes[spot.aerodrome];
+		ad.hotspots.insert(ad.frame.project(spot.position));
+	}
+
+	for (auto &ad : aerodromes) ad.hotspots.build();
+
+	trails.configure(
+		(std::uint32_t) std::clamp(options.trail_length, 0.0, (double) TRAIL_LENGTH_MAX),
+		(std::uint32_t) std::max(options.trail_decimation, 1.0)
+	);
+}
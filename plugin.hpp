@@ -0,0 +1,985 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numbers>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+#include <EuroScopePlugIn.hpp>
+
+#include "kernels.hpp"
+#include "recorder.hpp"
+
+namespace EuroScope = EuroScopePlugIn;
+
+#define PLUGIN_NAME    "vSMR+"
+#define PLUGIN_VERSION "0.3.3"
+#define PLUGIN_AUTHORS "Patrick Winters"
+#define PLUGIN_LICENSE "GNU GPLv3"
+
+#define ASR_TYPE "SMR radar display"
+
+#define COLOUR_CLOSED  0xff, 0x96, 0x00, 0x00
+#define COLOUR_HOTSPOT 0x80, 0xd9, 0x46, 0xef
+#define COLOUR_STUP    0xff, 0x10, 0xb9, 0x81
+#define COLOUR_PUSH    0xff, 0x3b, 0x82, 0xf6
+#define COLOUR_WARN    0xff, 0xf9, 0x73, 0x16
+#define COLOUR_QNH     0xff, 0xea, 0xb3, 0x08
+#define COLOUR_CLSD    0xff, 0xdc, 0x26, 0x26
+#define COLOUR_RWY     0xff, 0xe1, 0x1d, 0x48
+#define COLOUR_TRAIL   0xc0, 0xd4, 0xd4, 0xd4
+#define COLOUR_ROUTE   0xff, 0x22, 0xd3, 0xee
+#define COLOUR_BAR     0xff, 0xef, 0x44, 0x44
+#define COLOUR_SEQ     0xff, 0xe5, 0xe5, 0xe5
+#define COLOUR_ROSE_BG 0xff, 0xa3, 0xa3, 0xa3
+#define COLOUR_ARMS_L  0xff, 0x52, 0x52, 0x52
+#define COLOUR_ARMS_R  0xff, 0x73, 0x73, 0x73
+#define COLOUR_NORTH_L 0xff, 0xdc, 0x26, 0x26
+#define COLOUR_NORTH_R 0xff, 0xef, 0x44, 0x44
+
+const COLORREF COLOUR_STAND[] = {
+	RGB(0x66, 0x66, 0x66),
+	RGB(0xcd, 0x31, 0x31),
+	RGB(0x0d, 0xbc, 0x79),
+	RGB(0xe5, 0xe5, 0x10),
+	RGB(0x24, 0x72, 0xc8),
+	RGB(0xbc, 0x3f, 0xbc),
+	RGB(0x11, 0xa8, 0xcd),
+	RGB(0xe5, 0xe5, 0xe5)
+};
+
+const int TAG_ITEM_STAND = 101;
+const int TAG_FUNC_STAND = 201;
+const int TAG_FUNC_STAND_ALLOCATE = 205;
+const int TAG_FUNC_STAND_SELECT   = 206;
+
+const int TAG_ITEM_DEHIGHLIGHT = 102;
+const int TAG_FUNC_DEHIGHLIGHT = 202;
+
+const int TAG_ITEM_PRESSURE = 103;
+const int TAG_FUNC_PRESSURE_UPDATE = 203;
+const int TAG_FUNC_PRESSURE_RESET  = 204;
+
+const int TAG_ITEM_CLOSED = 104;
+
+const int TAG_ITEM_ROUTE = 105;
+const int TAG_FUNC_ROUTE = 207;
+const int TAG_FUNC_ROUTE_SELECT = 208;
+const int TAG_FUNC_ROUTE_CLEAR  = 209;
+
+const int TAG_ITEM_TAXIWAY = 106;
+
+const int TAG_ITEM_CONFORMANCE = 107;
+const int TAG_FUNC_ROUTE_EDIT   = 210;
+const int TAG_FUNC_ROUTE_EDITED = 211;
+
+const int TAG_FUNC_STOP_BAR        = 212;
+const int TAG_FUNC_STOP_BAR_TOGGLE = 213;
+
+const int TAG_ITEM_SEQUENCE = 108;
+
+const int TAG_ITEM_QUEUE = 109;
+
+const int OBJECT_TYPE_HOTSPOT = 1;
+const int OBJECT_TYPE_DEHIGHLIGHT = 2;
+
+const int HOTSPOT_SIZE = 16;
+const int HOTSPOT_STROKE = 2;
+const int HIGHLIGHT_SIZE = 24;
+const int HIGHLIGHT_STROKE = 2;
+const int QNH_HIGHLIGHT_SIZE = 32;
+const int CONFLICT_MARGIN = 16;
+const int TRAIL_DOT_SIZE = 3;
+const int TRAIL_LENGTH_MAX = 100;
+const float SEQ_FONT_SIZE = 9;
+const float SEQ_LINE_HEIGHT = 14;
+const float SEQ_MARGIN = 8;
+
+const float ROSE_BORDER_WIDTH = 1;
+const float ROSE_INNER_RADIUS = 6;
+const float ROSE_ARM_RADIUS   = 20;
+const float ROSE_NORTH_RADIUS = 32;
+
+const char CHAR_BOX_FILLED = '\xa4';
+const char CHAR_BOX_EMPTY  = '\xac';
+
+const double EARTH_RADIUS = 6371008.8; // m
+const float METRES_PER_NM = 1852;
+const float KNOT = 1852.0f / 3600; // m/s
+const float FRAME_RANGE = 40000; // m
+
+const float WARN_DIST = 185; // m
+const double HOTSPOT_CELL = 250; // m
+const double CLOSED_CELL = 500; // m
+
+const int GROUND_SPEED_MAX = 50; // kt
+const int STATIONARY_SPEED = 3; // kt
+
+const double STAND_CELL = 200; // m
+const float STAND_SNAP_DIST = 37; // m
+const float STAND_MOVE_DIST = 4; // m
+
+const double TAXI_CELL = 100; // m
+const float TAXI_SNAP_DIST = 5; // m
+const float TAXI_LINK_DIST = 250; // m
+const float MATCH_DIST = 30; // m
+const float MATCH_HEADING_WEIGHT = 20; // m
+const float MATCH_HYSTERESIS = 5; // m
+const size_t ROUTE_LOOKAHEAD = 4;
+const double BAR_CELL = 100; // m
+const size_t CROSSING_LOG_MAX = 100;
+const double SEQ_RANGE = 150; // nmi
+const int SEQ_HORIZON = 45; // min
+const double SEQ_ETA_STEP = 10; // s
+const int QUEUE_SPEED = 5; // kt
+const double QUEUE_PERCENTILE = 0.9;
+const float ROUTE_DEVIATION_DIST = 25; // m
+const float HOLD_OVERRUN_DIST = 15; // m
+const double STAND_ORIGIN_DIST = 10; // nmi
+const int STAND_SIZES = 6;
+const int STAND_POPUP_MAX = 20;
+const float RUNWAY_EXIT_FRACTION = 0.6;
+
+const float RUNWAY_HALF_WIDTH = 75; // m
+const float APPROACH_LENGTH = 9260; // m
+const float APPROACH_HALF_WIDTH = 555; // m
+const double APPROACH_MAX_ANGLE = 30; // deg
+const int RUNWAY_ROLL_SPEED = 40; // kt
+
+const int DEHIGHLIGHT_CHECK_INTERVAL = 60; // s
+const int TARGET_TIMEOUT = 60; // s
+const int TARGET_CHECK_INTERVAL = 15; // s
+
+const std::uint32_t AC_DEHIGHLIGHT  = 1 << 0;
+const std::uint32_t AC_PRESSURE     = 1 << 1;
+const std::uint32_t AC_WARN         = 1 << 2;
+const std::uint32_t AC_DEVIATION    = 1 << 3;
+const std::uint32_t AC_OVERRUN      = 1 << 4;
+const std::uint32_t AC_BLOCKED      = 1 << 5;
+
+enum GroundState : std::uint8_t {
+	GS_NONE,
+	GS_STUP,
+	GS_PUSH,
+	GS_TAXI,
+	GS_DEPA,
+	GS_OTHER,
+	GS_COUNT
+};
+
+// orthographic projection onto the plane touching a spherical earth at an
+// origin, i.e. the east and north components of the offset in ECEF; across
+// an aerodrome this is accurate to centimetres
+struct LocalFrame {
+	double lat0, lon0, sin_lat0, cos_lat0;
+
+	LocalFrame() = default;
+	explicit LocalFrame(const EuroScope::CPosition &);
+
+	Vec2 project(const EuroScope::CPosition &) const;
+	EuroScope::CPosition unproject(Vec2) const;
+};
+
+struct Hotspot {
+	EuroScope::CPosition position;
+	std::string value;
+	std::uint32_t colour;
+	std::uint32_t aerodrome;
+};
+
+struct ClosedArea {
+	std::vector<EuroScope::CPosition> poly;
+
+	std::uint32_t aerodrome;
+	std::vector<Vec2> local;
+	float x0, y0, x1, y1;
+
+	// edges indexed by horizontal band, so casting a ray from a point only
+	// tests the edges that span its northing
+	float band;
+	std::vector<std::vector<std::uint32_t>> bands;
+
+	ClosedArea(std::vector<EuroScope::CPosition>, std::uint32_t, const LocalFrame &);
+	bool contains(Vec2) const;
+};
+
+struct Runway {
+	std::uint32_t aerodrome;
+	std::string name[2];
+	EuroScope::CPosition corner[4];
+
+	// threshold 0, and unit vector and length in metres from it to
+	// threshold 1
+	Vec2 start;
+	float ux, uy, length;
+
+	std::vector<std::uint32_t> occupants, finals;
+	bool conflict;
+};
+
+struct Options {
+	double warn_lookahead = 30; // s
+	double final_alert = 60; // s
+	double approach_ceiling = 4000; // ft
+	double conflict_radius = 0.03; // nmi
+	double conflict_horizon = 10; // s
+	double trail_length = 10;
+	double trail_decimation = 1;
+};
+
+struct StandInfo {
+	char letter, prop_letter;
+	size_t colour : 8, prop_colour : 8;
+	std::string details;
+	std::uint32_t index = UINT32_MAX;
+};
+
+
+struct TimerTask {
+	std::string name;
+	std::function<void()> callback;
+	unsigned interval;
+
+	std::uint64_t expiry;
+	TimerTask *prev, *next, **list;
+	size_t index;
+	bool cancelled;
+
+	std::uint64_t runs;
+	std::chrono::steady_clock::duration total, max;
+};
+
+// hierarchical timing wheel in ticks of one second; each level has 64 slots,
+// so tasks due within 64 s sit in the innermost level and later tasks are
+// cascaded down as the wheel turns. inserting and cancelling are O(1), and a
+// tick only touches the tasks in one slot
+class TimerWheel {
+private:
+	static const int LEVELS = 3;
+	static const int SLOT_BITS = 6;
+	static const int SLOTS = 1 << SLOT_BITS;
+
+	TimerTask *slots[LEVELS][SLOTS] = {};
+	TimerTask *pending = nullptr;
+	std::uint64_t now = 0;
+
+	std::vector<std::unique_ptr<TimerTask>> tasks;
+
+	void insert(TimerTask *);
+	void unlink(TimerTask *);
+	void destroy(TimerTask *);
+	void cascade(int, int);
+
+public:
+	TimerTask *schedule(std::string, unsigned, std::function<void()>, unsigned = 0);
+	void cancel(TimerTask *);
+	void tick();
+
+	// ticks so far, in seconds as EuroScope calls OnTimer
+	std::uint64_t time() const { return now; }
+
+	const decltype(tasks) &all() const { return tasks; }
+};
+
+struct StringHash {
+	using is_transparent = void;
+
+	size_t operator()(std::string_view value) const {
+		return std::hash<std::string_view>()(value);
+	}
+};
+
+template<typename T>
+using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+// maps each callsign seen to a dense handle, so per-aircraft state can live in
+// plain arrays; handles are recycled once the aircraft disconnects
+class CallsignTable {
+private:
+	StringMap<std::uint32_t> handles;
+	std::vector<std::string> names;
+	std::vector<std::uint32_t> unused;
+
+public:
+	static const std::uint32_t NONE = UINT32_MAX;
+
+	std::uint32_t find(std::string_view) const;
+	std::uint32_t intern(std::string_view);
+	void release(std::uint32_t);
+
+	const std::string &name(std::uint32_t handle) const { return names[handle]; }
+	std::uint32_t capacity() const { return names.size(); }
+};
+
+// set of aircraft handles or other dense indices as a bitmap, iterated in
+// ascending order
+class IndexSet {
+private:
+	std::vector<std::uint64_t> words;
+
+public:
+	bool contains(std::uint32_t ac) const {
+		return ac / 64 < words.size() && words[ac / 64] >> (ac % 64) & 1;
+	}
+
+	void insert(std::uint32_t ac) {
+		if (ac / 64 >= words.size()) words.resize(ac / 64 + 1);
+		words[ac / 64] |= (std::uint64_t) 1 << (ac % 64);
+	}
+
+	void erase(std::uint32_t ac) {
+		if (ac / 64 < words.size()) words[ac / 64] &= ~((std::uint64_t) 1 << (ac % 64));
+	}
+
+	// raw words, for combining sets a word at a time
+	size_t word_count() const { return words.size(); }
+	std::uint64_t word(size_t i) const { return i < words.size() ? words[i] : 0; }
+
+	template<typename F>
+	void for_each(F f) const {
+		for (size_t i = 0; i < words.size(); i++)
+			for (auto word = words[i]; word; word &= word - 1)
+				f((std::uint32_t) (i * 64 + std::countr_zero(word)));
+	}
+};
+
+// uniform grid over a plane, mapping each cell to the ids of the items whose
+// bounding boxes overlap it; an id may be reported once per cell it occupies
+class SpatialGrid {
+private:
+	double cell;
+	std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> cells;
+
+	static std::uint64_t key(std::int32_t x, std::int32_t y) {
+		return (std::uint64_t) (std::uint32_t) x << 32 | (std::uint32_t) y;
+	}
+
+public:
+	explicit SpatialGrid(double cell) : cell(cell) {}
+
+	void clear() { cells.clear(); }
+
+	void insert(double x0, double y0, double x1, double y1, std::uint32_t id) {
+		for (auto x = (std::int32_t) std::floor(x0 / cell); x <= (std::int32_t) std::floor(x1 / cell); x++)
+			for (auto y = (std::int32_t) std::floor(y0 / cell); y <= (std::int32_t) std::floor(y1 / cell); y++)
+				cells[key(x, y)].push_back(id);
+	}
+
+	template<typename F>
+	void query(double x0, double y0, double x1, double y1, F f) const {
+		for (auto x = (std::int32_t) std::floor(x0 / cell); x <= (std::int32_t) std::floor(x1 / cell); x++) {
+			for (auto y = (std::int32_t) std::floor(y0 / cell); y <= (std::int32_t) std::floor(y1 / cell); y++) {
+				auto it = cells.find(key(x, y));
+				if (it == cells.cend()) continue;
+
+				for (auto id : std::get<1>(*it)) f(id);
+			}
+		}
+	}
+};
+
+// points stored contiguously by grid cell, so a query hands each cell it
+// covers to the batch kernels as one run
+class PointGrid {
+private:
+	double cell;
+	std::vector<Vec2> points;
+	std::unordered_map<std::uint64_t, std::pair<std::uint32_t, std::uint32_t>> cells;
+
+	std::pair<std::int32_t, std::int32_t> at(double x, double y) const {
+		return { (std::int32_t) std::floor(x / cell), (std::int32_t) std::floor(y / cell) };
+	}
+
+	static std::uint64_t key(std::pair<std::int32_t, std::int32_t> c) {
+		return (std::uint64_t) (std::uint32_t) std::get<0>(c) << 32 | (std::uint32_t) std::get<1>(c);
+	}
+
+public:
+	explicit PointGrid(double cell) : cell(cell) {}
+
+	size_t size() const { return points.size(); }
+
+	void clear() {
+		points.clear();
+		cells.clear();
+	}
+
+	void insert(Vec2 p) {
+		points.push_back(p);
+	}
+
+	// sorts the points by cell; needed after inserting, before querying
+	void build() {
+		std::sort(points.begin(), points.end(), [&](Vec2 a, Vec2 b) { return key(at(a.x, a.y)) < key(at(b.x, b.y)); });
+
+		cells.clear();
+		for (std::uint32_t i = 0; i < points.size(); i++) {
+			auto [it, added] = cells.try_emplace(key(at(points[i].x, points[i].y)), i, i);
+			std::get<1>(std::get<1>(*it)) = i + 1;
+		}
+	}
+
+	template<typename F>
+	void query(double x0, double y0, double x1, double y1, F f) const {
+		auto [cx0, cy0] = at(x0, y0);
+		auto [cx1, cy1] = at(x1, y1);
+
+		for (auto x = cx0; x <= cx1; x++) {
+			for (auto y = cy0; y <= cy1; y++) {
+				auto it = cells.find(key({ x, y }));
+				if (it == cells.cend()) continue;
+
+				auto [begin, end] = std::get<1>(*it);
+				f(points.data() + begin, end - begin);
+			}
+		}
+	}
+};
+
+// streaming estimate of one quantile in constant space, by the P-square
+// algorithm of Jain and Chlamtac; exact until five samples are in
+class P2Quantile {
+private:
+	double p;
+	std::uint64_t count = 0;
+	double q[5], n[5], want[5], step[5];
+
+public:
+	explicit P2Quantile(double p) : p(p) {}
+
+	std::uint64_t size() const { return count; }
+
+	void push(double x) {
+		if (count < 5) {
+			q[count++] = x;
+			if (count < 5) return;
+
+			std::sort(q, q + 5);
+
+			double init[5] = { 0, 2 * p, 4 * p, 2 + 2 * p, 4 }, inc[5] = { 0, p / 2, p, (1 + p) / 2, 1 };
+			for (int i = 0; i < 5; i++) {
+				n[i] = i;
+				want[i] = init[i];
+				step[i] = inc[i];
+			}
+
+			return;
+		}
+
+		count++;
+
+		int k;
+		if (x < q[0]) {
+			q[0] = x;
+			k = 0;
+		} else if (x >= q[4]) {
+			q[4] = x;
+			k = 3;
+		} else {
+			for (k = 0; x >= q[k + 1]; k++);
+		}
+
+		for (int i = k + 1; i < 5; i++) n[i]++;
+		for (int i = 0; i < 5; i++) want[i] += step[i];
+
+		// move the middle markers towards where they should be, along a
+		// parabola through their neighbours if that stays in order
+		for (int i = 1; i < 4; i++) {
+			double d = want[i] - n[i];
+			if (!(d >= 1 && n[i + 1] - n[i] > 1) && !(d <= -1 && n[i - 1] - n[i] < -1)) continue;
+
+			int s = d > 0 ? 1 : -1;
+			double parabolic = q[i] + s / (n[i + 1] - n[i - 1]) * (
+				(n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+				(n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) / (n[i] - n[i - 1])
+			);
+
+			if (q[i - 1] < parabolic && parabolic < q[i + 1]) q[i] = parabolic;
+			else q[i] += s * (q[i + s] - q[i]) / (n[i + s] - n[i]);
+
+			n[i] += s;
+		}
+	}
+
+	double value() const {
+		if (count >= 5) return q[2];
+		if (!count) return NAN;
+
+		double sorted[5];
+		std::copy(q, q + count, sorted);
+		std::sort(sorted, sorted + count);
+
+		return sorted[(size_t) std::lround(p * (count - 1))];
+	}
+};
+
+// position history of each aircraft handle, as fixed-capacity rings of
+// fixed-point coordinates in units of 1e-7 deg, laid out as one array per
+// coordinate so that a handle's ring is contiguous
+class TrailStore {
+private:
+	std::uint32_t length = 0, decimation = 1;
+
+	std::vector<std::int32_t> lat, lon;
+	std::vector<std::uint16_t> head, count, skipped;
+
+public:
+	static constexpr double SCALE = 1e7;
+
+	void configure(std::uint32_t length, std::uint32_t decimation) {
+		if (length == this->length && decimation == this->decimation) return;
+
+		this->length = length;
+		this->decimation = std::max(decimation, 1u);
+
+		auto handles = head.size();
+		lat.assign(handles * length, 0);
+		lon.assign(handles * length, 0);
+		std::fill(count.begin(), count.end(), 0);
+	}
+
+	void resize(std::uint32_t handles) {
+		lat.resize(handles * length);
+		lon.resize(handles * length);
+		head.resize(handles);
+		count.resize(handles);
+		skipped.resize(handles);
+	}
+
+	void clear(std::uint32_t ac) {
+		count[ac] = skipped[ac] = 0;
+	}
+
+	void push(std::uint32_t ac, const EuroScope::CPosition &posn) {
+		if (!length || ++skipped[ac] < decimation) return;
+		skipped[ac] = 0;
+
+		head[ac] = (head[ac] + 1) % length;
+		count[ac] = std::min<std::uint32_t>(count[ac] + 1, length);
+
+		lat[ac * length + head[ac]] = (std::int32_t) std::lround(posn.m_Latitude * SCALE);
+		lon[ac * length + head[ac]] = (std::int32_t) std::lround(posn.m_Longitude * SCALE);
+	}
+
+	// newest first
+	template<typename F>
+	void for_each(std::uint32_t ac, F f) const {
+		for (std::uint32_t i = 0; i < count[ac]; i++) {
+			auto slot = ac * length + (head[ac] + length - i) % length;
+
+			EuroScope::CPosition posn;
+			posn.m_Latitude = lat[slot] / SCALE;
+			posn.m_Longitude = lon[slot] / SCALE;
+			f(posn);
+		}
+	}
+
+	size_t memory() const {
+		return (lat.capacity() + lon.capacity()) * sizeof(std::int32_t)
+			+ (head.capacity() + count.capacity() + skipped.capacity()) * sizeof(std::uint16_t);
+	}
+};
+
+// stands with a known position at one aerodrome, by index
+struct StandIndex {
+	std::uint32_t aerodrome = UINT32_MAX;
+	std::vector<std::string> names;
+	std::vector<Vec2> positions;
+	std::vector<char> letter, prop_letter, size;
+	std::vector<std::uint32_t> occupant;
+	std::vector<std::uint16_t> occupants, assignments;
+	IndexSet occupied, assigned;
+	SpatialGrid grid { STAND_CELL };
+
+	// availability by category letter, and by the smallest size code each
+	// stand takes, so candidates can be found a word at a time
+	std::unordered_map<char, IndexSet> category, prop_category;
+	std::array<IndexSet, STAND_SIZES> fits;
+
+	// by the size codes each stand's letter takes, read as a code letter;
+	// letters other than A to F are not code letters, and take any
+	std::array<IndexSet, STAND_SIZES> takes, prop_takes;
+};
+
+// taxiway centrelines as straight edges between nodes, where nodes closer
+// than TAXI_SNAP_DIST are merged so centrelines meet where they share a
+// point; routes are cached by their ends until the closures change
+class TaxiGraph {
+public:
+	struct Edge {
+		std::uint32_t a, b, taxiway;
+		float length;
+	};
+
+	std::vector<Vec2> nodes;
+	std::vector<EuroScope::CPosition> positions;
+	std::vector<Edge> edges;
+	std::vector<std::vector<std::uint32_t>> adjacent;
+	std::vector<std::string> taxiways;
+
+private:
+	SpatialGrid grid { TAXI_CELL }, edge_grid { TAXI_CELL };
+	std::vector<std::uint8_t> blocked;
+
+	struct Route {
+		std::uint32_t generation;
+		std::vector<std::uint32_t> edges;
+	};
+
+	std::uint32_t generation = 0;
+	std::unordered_map<std::uint64_t, Route> routes;
+
+	void add_edge(std::uint32_t, std::uint32_t, std::uint32_t);
+
+public:
+	std::uint64_t hits = 0, misses = 0;
+
+	std::uint32_t node(Vec2, const EuroScope::CPosition &);
+	void add(const std::string &, const std::vector<Vec2> &, const std::vector<EuroScope::CPosition> &);
+	std::uint32_t link(Vec2, const EuroScope::CPosition &);
+	std::uint32_t nearest(Vec2, float, std::uint32_t = UINT32_MAX) const;
+
+	void block(std::vector<std::uint8_t>);
+	const std::vector<std::uint32_t> *route(std::uint32_t, std::uint32_t);
+
+	bool is_blocked(std::uint32_t edge) const { return blocked[edge]; }
+
+	// A* from a node over the allowed edges to the first goal node reached;
+	// fills in the edges taken and returns the goal, or UINT32_MAX
+	template<typename Goal, typename Allowed, typename Heuristic>
+	std::uint32_t search(std::uint32_t from, Goal goal, Allowed allowed, Heuristic heuristic, std::vector<std::uint32_t> &path) const {
+		std::vector<float> cost(nodes.size(), INFINITY);
+		std::vector<std::uint32_t> via(nodes.size(), UINT32_MAX);
+
+		using Entry = std::pair<float, std::uint32_t>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+		cost[from] = 0;
+		open.emplace(heuristic(from), from);
+
+		std::uint32_t reached = UINT32_MAX;
+
+		while (!open.empty()) {
+			auto [estimate, n] = open.top();
+			open.pop();
+
+			if (estimate > cost[n] + heuristic(n)) continue;
+			if (goal(n)) {
+				reached = n;
+				break;
+			}
+
+			for (auto e : adjacent[n]) {
+				if (!allowed(e)) continue;
+
+				auto m = other(e, n);
+				float c = cost[n] + edges[e].length;
+				if (c >= cost[m]) continue;
+
+				cost[m] = c;
+				via[m] = e;
+				open.emplace(c + heuristic(m), m);
+			}
+		}
+
+		path.clear();
+		if (reached == UINT32_MAX) return reached;
+
+		for (auto n = reached; n != from; n = other(via[n], n)) path.push_back(via[n]);
+		std::reverse(path.begin(), path.end());
+
+		return reached;
+	}
+
+	std::uint32_t other(std::uint32_t edge, std::uint32_t node) const {
+		return edges[edge].a == node ? edges[edge].b : edges[edge].a;
+	}
+
+	// distance from p to an edge, and how far along it p lies
+	float distance(std::uint32_t edge, Vec2 p, float &along) const {
+		const auto &a = nodes[edges[edge].a], &b = nodes[edges[edge].b];
+		float ux = (b.x - a.x) / edges[edge].length, uy = (b.y - a.y) / edges[edge].length;
+
+		along = std::clamp((p.x - a.x) * ux + (p.y - a.y) * uy, 0.0f, edges[edge].length);
+		return std::hypot(p.x - a.x - along * ux, p.y - a.y - along * uy);
+	}
+
+	// edges whose bounding boxes come within range of p; an edge may be
+	// reported more than once
+	template<typename F>
+	void edges_near(Vec2 p, float range, F f) const {
+		edge_grid.query(p.x - range, p.y - range, p.x + range, p.y + range, f);
+	}
+
+	size_t cached() const { return routes.size(); }
+};
+
+struct HoldingPoint {
+	std::string runway, name;
+	std::uint32_t node;
+};
+
+// stop bar across a holding point, lit unless switched off
+struct StopBar {
+	std::string runway, name;
+	EuroScope::CPosition posn[2];
+	Vec2 a, b;
+	bool lit = true;
+};
+
+// a lit stop bar crossed, as logged
+struct Crossing {
+	std::time_t time;
+	std::string callsign;
+	std::uint32_t aerodrome, bar;
+};
+
+// area before a holding point, with the aircraft waiting in it in the order
+// they joined, and how long those that have left waited
+struct QueueArea {
+	std::string runway, name;
+	ClosedArea area;
+
+	std::vector<std::uint32_t> aircraft;
+	std::uint64_t waits = 0;
+	double total_wait = 0;
+	P2Quantile wait_p90 { QUEUE_PERCENTILE };
+};
+
+// arrivals to one runway, in order of predicted touchdown
+struct Sequence {
+	std::uint32_t aerodrome;
+	std::string runway;
+	std::vector<std::uint32_t> arrivals;
+};
+
+// touchdown last found from an arrival's predicted path, kept until the
+// prediction or the flight plan changes. points is zero once stale
+struct Arrival {
+	int points = 0;
+	EuroScope::CPosition first, last;
+	std::uint32_t sequence = UINT32_MAX;
+	double eta = 0;
+};
+
+// taxi route given to an aircraft; either the shortest route to a holding
+// point, or the taxiways the controller typed. next is the index of the edge
+// the aircraft is expected on
+struct TaxiRoute {
+	std::uint32_t aerodrome = UINT32_MAX, from, hold;
+	std::vector<std::uint32_t> nodes, edges;
+	size_t next = 0;
+	bool typed = false;
+};
+
+// active aerodrome, with its surface features in its own local frame
+struct Aerodrome {
+	std::string name;
+	LocalFrame frame;
+
+	PointGrid hotspots { HOTSPOT_CELL };
+	SpatialGrid closed { CLOSED_CELL };
+	std::vector<std::uint32_t> runways;
+
+	TaxiGraph taxi;
+	std::vector<HoldingPoint> holds;
+
+	std::vector<StopBar> bars;
+	SpatialGrid bar_grid { BAR_CELL };
+
+	std::vector<QueueArea> queues;
+	SpatialGrid queue_grid { CLOSED_CELL };
+
+	// this aerodrome's entry in stand_index, if it has stands
+	StandIndex *stands = nullptr;
+};
+
+// pens an aircraft can be ringed with
+enum Mark : std::uint8_t {
+	MARK_STUP,
+	MARK_PUSH,
+	MARK_WARN,
+	MARK_QNH,
+	MARK_CLSD,
+	MARK_RWY,
+	MARK_COUNT
+};
+
+struct Highlight {
+	std::uint32_t ac;
+	Mark mark;
+	int size;
+};
+
+class Plugin;
+
+class Screen : public EuroScope::CRadarScreen {
+private:
+	Plugin *plugin;
+	std::vector<std::uint8_t> visible, inside;
+
+	void find_visible(RECT);
+	void draw(HDC, int);
+
+public:
+	std::vector<Highlight> highlights;
+	std::vector<std::string> lines;
+
+	Screen(Plugin *p) : plugin(p) {}
+	virtual ~Screen() = default;
+
+	void find_highlights(RECT);
+	void list_lines();
+
+	void OnAsrContentToBeClosed(void) override;
+	void OnRefresh(HDC, int) override;
+	void OnClickScreenObject(int, const char *, POINT, RECT, int) override;
+};
+
+class Plugin : public EuroScope::CPlugIn {
+	friend class Screen;
+
+private:
+	std::vector<Aerodrome> aerodromes;
+	std::vector<Hotspot> hotspot;
+	StringMap<const Hotspot *> hotspot_by_name;
+	std::vector<ClosedArea> closed;
+	std::vector<Runway> runways;
+
+	std::unordered_map<std::string, std::unordered_map<std::string, StandInfo>> stands;
+	StringMap<StandIndex> stand_index;
+
+	CallsignTable callsigns;
+	std::vector<std::uint32_t> ac_flags;
+	std::vector<std::array<char, 3>> ac_pressure;
+	std::vector<std::string> ac_origin, ac_scratchpad;
+	std::vector<GroundState> ac_ground_state;
+	std::vector<EuroScope::CPosition> ac_position;
+	std::vector<std::uint32_t> ac_aerodrome;
+	std::vector<Vec2> ac_local;
+	std::vector<int> ac_gs, ac_altitude;
+	std::vector<double> ac_track;
+	std::vector<std::uint32_t> ac_closed, ac_runway, ac_final;
+	std::vector<std::pair<StandIndex *, std::uint32_t>> ac_stand, ac_assigned;
+	std::vector<TaxiRoute> ac_route;
+	std::vector<std::uint32_t> ac_edge;
+	std::vector<Vec2> ac_snapped;
+	std::vector<std::uint64_t> ac_seen;
+
+	std::array<IndexSet, GS_COUNT> ground_state_set;
+	IndexSet pressure_due, in_closed, routed;
+	std::unordered_set<std::string> closed_taxiways;
+	std::deque<Crossing> crossings;
+	std::vector<std::uint32_t> bars_seen;
+
+	std::vector<Sequence> sequences;
+	std::vector<std::uint32_t> ac_sequence, ac_landing;
+	std::vector<double> ac_eta;
+	std::vector<Arrival> ac_arrival;
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> ac_queue;
+	std::vector<std::time_t> ac_queued;
+
+	std::uint64_t match_updates = 0, match_searches = 0;
+	std::chrono::steady_clock::duration match_time {};
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> conflicts;
+	TrailStore trails;
+
+	StringMap<std::array<char, 3>> ad_pressure;
+	StringMap<std::unordered_set<std::uint32_t>> ad_aircraft;
+	EuroScope::CFlightPlanList pressure_due_list;
+
+	Options options;
+
+	TimerWheel timers;
+	Recorder recorder;
+
+public:
+	Plugin(void) : CPlugIn(
+		EuroScope::COMPATIBILITY_CODE,
+		PLUGIN_NAME, PLUGIN_VERSION, PLUGIN_AUTHORS, PLUGIN_LICENSE
+	) {
+		try {
+			init();
+		} catch (const std::exception &err) {
+			warn(err.what());
+			throw;
+		}
+	}
+
+	Screen *OnRadarScreenCreated(const char *, bool, bool, bool, bool) override;
+	void OnAirportRunwayActivityChanged() override;
+	bool OnCompileCommand(const char *) override;
+	void OnFlightPlanDisconnect(EuroScope::CFlightPlan) override;
+	void OnFlightPlanFlightPlanDataUpdate(EuroScope::CFlightPlan) override;
+	void OnFlightPlanControllerAssignedDataUpdate(EuroScope::CFlightPlan, int) override;
+	void OnFunctionCall(int, const char *, POINT, RECT) override;
+	void OnRadarTargetPositionUpdate(EuroScope::CRadarTarget) override;
+	void OnGetTagItem(EuroScope::CFlightPlan, EuroScope::CRadarTarget, int, int, char[16], int *, COLORREF *, double *) override;
+	void OnNewMetarReceived(const char *, const char *) override;
+	void OnTimer(int) override;
+
+private:
+	void init();
+	void warn(const char *);
+	void load();
+	void stats();
+	void record(const char *);
+
+	std::uint32_t aircraft(const char *);
+	void release(std::uint32_t);
+	void set_origin(std::uint32_t, const char *);
+	void set_position(std::uint32_t, const EuroScope::CPosition &);
+	std::uint32_t locate(const EuroScope::CPosition &, Vec2 &) const;
+	void set_pressure_due(EuroScope::CFlightPlan, std::uint32_t, bool);
+	void set_ground_state(std::uint32_t, GroundState);
+	void update_warn(std::uint32_t);
+	void update_closed(std::uint32_t);
+	void update_runway(std::uint32_t);
+	void set_runway(std::uint32_t, std::uint32_t, std::uint32_t);
+	void check_runway(std::uint32_t);
+	void check_conflicts();
+	void update_stand(std::uint32_t);
+	void set_stand(std::uint32_t, StandIndex *, std::uint32_t);
+	void update_assigned(std::uint32_t, EuroScope::CFlightPlan);
+	void set_assigned(std::uint32_t, StandIndex *, std::uint32_t);
+	void allocate_stand(EuroScope::CFlightPlan, RECT);
+	void update_closures();
+	void update_taxiway(std::uint32_t);
+	bool set_route(std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t);
+	void assign_route(std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t, std::vector<std::uint32_t>);
+	bool parse_route(std::uint32_t, const char *);
+	std::string route_text(const TaxiRoute &) const;
+	void update_conformance(std::uint32_t);
+	void check_bars(std::uint32_t, std::uint32_t, Vec2);
+	void list_crossings();
+	void update_arrival(std::uint32_t, EuroScope::CFlightPlan);
+	void set_sequence(std::uint32_t, std::uint32_t, double);
+	void update_queue(std::uint32_t);
+	void set_queue(std::uint32_t, std::uint32_t, std::uint32_t);
+};
+
+// where the configuration file is, found by the host; empty if unknown
+std::string config_path();
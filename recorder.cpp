@@ -0,0 +1,362 @@
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+#include <algorithm>
+
+#include "recorder.hpp"
+
+bool Recorder::start(const std::string &path) {
+	if (file) return false;
+
+	file = std::fopen(path.c_str(), "wb");
+	if (!file) return false;
+
+	if (!front) {
+		front = std::make_unique<char[]>(BUFFER_SIZE);
+		back = std::make_unique<char[]>(BUFFER_SIZE);
+	}
+
+	scratch.clear();
+	scratch.header(std::time(nullptr));
+	std::fwrite(scratch.data().data(), 1, scratch.size(), file);
+
+	start_time = std::chrono::steady_clock::now();
+	records = bytes = dropped = 0;
+	tag_items = 0;
+	last_area = {};
+
+	writer = std::thread([this] { write(); });
+
+	return true;
+}
+
+void Recorder::stop() {
+	if (!file) return;
+
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+
+	wake.notify_one();
+	writer.join();
+
+	// the writer has written out the back buffer and gone, so the rest can
+	// be written from here
+	std::fwrite(front.get(), 1, front_used, file);
+	std::fclose(file);
+
+	file = nullptr;
+	front_used = 0;
+	stopping = false;
+	ids.clear();
+}
+
+void Recorder::flush() {
+	if (file && front_used) swap();
+}
+
+void Recorder::write() {
+	std::unique_lock lock(mutex);
+
+	for (;;) {
+		wake.wait(lock, [this] { return back_full || stopping; });
+
+		if (back_full) {
+			lock.unlock();
+			std::fwrite(back.get(), 1, back_used, file);
+			std::fflush(file);
+			lock.lock();
+
+			back_full = false;
+			continue;
+		}
+
+		return;
+	}
+}
+
+bool Recorder::swap() {
+	{
+		std::lock_guard lock(mutex);
+		if (back_full) return false;
+
+		std::swap(front, back);
+		back_used = front_used;
+		back_full = true;
+	}
+
+	front_used = 0;
+	wake.notify_one();
+
+	return true;
+}
+
+void Recorder::begin(record::Type type) {
+	using namespace std::chrono;
+
+	scratch.clear();
+	scratch.begin(type, (std::uint32_t) duration_cast<milliseconds>(steady_clock::now() - start_time).count());
+}
+
+void Recorder::end() {
+	const auto &data = scratch.data();
+
+	if (!scratch.end() || (front_used + data.size() > BUFFER_SIZE && !swap())) {
+		dropped++;
+		return;
+	}
+
+	std::memcpy(front.get() + front_used, data.data(), data.size());
+	front_used += data.size();
+
+	records++;
+	bytes += data.size();
+}
+
+// the id for a callsign, first logging which callsign it stands for
+std::uint32_t Recorder::id(const char *callsign) {
+	auto [it, added] = ids.try_emplace(callsign, (std::uint32_t) ids.size());
+	auto ac = std::get<1>(*it);
+
+	if (added) {
+		begin(record::CALLSIGN);
+		scratch.u32(ac);
+		scratch.str(callsign);
+		end();
+	}
+
+	return ac;
+}
+
+void Recorder::position(EuroScope::CRadarTarget rt) {
+	if (!file) return;
+
+	auto ac = id(rt.GetCallsign());
+	auto posn = rt.GetPosition();
+	auto track = std::lround(rt.GetTrackHeading() * 100) % 36000;
+
+	begin(record::POSITION);
+	scratch.u32(ac);
+	scratch.position(posn.GetPosition());
+	scratch.i32(posn.GetPressureAltitude());
+	scratch.u16((std::uint16_t) std::clamp(rt.GetGS(), 0, UINT16_MAX));
+	scratch.u16((std::uint16_t) (track < 0 ? track + 36000 : track));
+	end();
+}
+
+void Recorder::flight_plan(EuroScope::CFlightPlan fp) {
+	if (!file) return;
+
+	auto ac = id(fp.GetCallsign());
+	auto data = fp.GetFlightPlanData();
+
+	begin(record::FLIGHT_PLAN);
+	scratch.u32(ac);
+	scratch.str(data.GetOrigin());
+	scratch.str(data.GetDestination());
+	scratch.str(data.GetDepartureRwy());
+	scratch.str(data.GetArrivalRwy());
+	scratch.u8(data.GetEngineType());
+	scratch.u8(data.GetAircraftWtc());
+	scratch.str(fp.GetGroundState());
+	end();
+}
+
+void Recorder::assigned(EuroScope::CFlightPlan fp, int type) {
+	if (!file) return;
+
+	auto ac = id(fp.GetCallsign());
+	auto data = fp.GetControllerAssignedData();
+
+	begin(record::ASSIGNED);
+	scratch.u32(ac);
+	scratch.u8(type);
+	scratch.str(fp.GetGroundState());
+	scratch.str(data.GetScratchPadString());
+	scratch.str(data.GetFlightStripAnnotation(3));
+	end();
+}
+
+void Recorder::disconnect(EuroScope::CFlightPlan fp) {
+	if (!file) return;
+
+	auto ac = id(fp.GetCallsign());
+
+	begin(record::DISCONNECT);
+	scratch.u32(ac);
+	end();
+}
+
+void Recorder::metar(const char *ad, const char *metar) {
+	if (!file) return;
+
+	begin(record::METAR);
+	scratch.str(ad);
+	scratch.str(metar);
+	end();
+}
+
+// the aerodromes and runway ends active, as they are after a change
+void Recorder::runways(EuroScope::CPlugIn &plugin) {
+	if (!file) return;
+
+	begin(record::RUNWAYS);
+
+	size_t count_at = scratch.size();
+	std::uint16_t count = 0;
+	scratch.u16(0);
+
+	for (
+		auto el = plugin.SectorFileElementSelectFirst(EuroScope::SECTOR_ELEMENT_AIRPORT);
+		el.IsValid();
+		el = plugin.SectorFileElementSelectNext(el, EuroScope::SECTOR_ELEMENT_AIRPORT)
+	) {
+		std::uint8_t flags = el.IsElementActive(true, 0) | el.IsElementActive(false, 0) << 1;
+		if (!flags) continue;
+
+		scratch.str(el.GetName());
+		scratch.str("");
+		scratch.u8(flags);
+		count++;
+	}
+
+	for (
+		auto el = plugin.SectorFileElementSelectFirst(EuroScope::SECTOR_ELEMENT_RUNWAY);
+		el.IsValid();
+		el = plugin.SectorFileElementSelectNext(el, EuroScope::SECTOR_ELEMENT_RUNWAY)
+	) {
+		for (int i = 0; i < 2; i++) {
+			std::uint8_t flags = el.IsElementActive(true, i) | el.IsElementActive(false, i) << 1;
+			if (!flags) continue;
+
+			scratch.str(el.GetAirportName());
+			scratch.str(el.GetRunwayName(i));
+			scratch.u8(flags);
+			count++;
+		}
+	}
+
+	scratch.set_u16(count_at, count);
+	end();
+}
+
+// the sector elements the plugin looks up, for replaying without the sector
+// file
+void Recorder::elements(EuroScope::CPlugIn &plugin) {
+	static const int types[] = {
+		EuroScope::SECTOR_ELEMENT_AIRPORT,
+		EuroScope::SECTOR_ELEMENT_RUNWAY,
+		EuroScope::SECTOR_ELEMENT_FREE_TEXT
+	};
+
+	if (!file) return;
+
+	for (auto type : types) {
+		for (
+			auto el = plugin.SectorFileElementSelectFirst(type);
+			el.IsValid();
+			el = plugin.SectorFileElementSelectNext(el, type)
+		) {
+			EuroScope::CPosition posn[2];
+			el.GetPosition(&posn[0], 0);
+			if (type == EuroScope::SECTOR_ELEMENT_RUNWAY) el.GetPosition(&posn[1], 1);
+
+			bool runway = type == EuroScope::SECTOR_ELEMENT_RUNWAY;
+
+			begin(record::ELEMENT);
+			scratch.u8(type);
+			scratch.str(el.GetName());
+			scratch.str(runway ? el.GetAirportName() : "");
+			scratch.str(runway ? el.GetRunwayName(0) : "");
+			scratch.str(runway ? el.GetRunwayName(1) : "");
+			scratch.position(posn[0]);
+			scratch.position(posn[1]);
+			end();
+		}
+	}
+}
+
+void Recorder::controller(EuroScope::CController ctr) {
+	if (!file) return;
+
+	begin(record::CONTROLLER);
+	scratch.position(ctr.GetPosition());
+	scratch.i32(ctr.GetRange());
+	end();
+}
+
+// marks the end of the snapshot the log opens with
+void Recorder::live() {
+	if (!file) return;
+
+	begin(record::LIVE);
+	end();
+}
+
+void Recorder::refresh(int phase, std::chrono::steady_clock::duration taken) {
+	using namespace std::chrono;
+
+	if (!file) return;
+
+	begin(record::REFRESH);
+	scratch.u8(phase);
+	scratch.u32((std::uint32_t) duration_cast<microseconds>(taken).count());
+	scratch.u32(tag_items);
+	end();
+
+	tag_items = 0;
+}
+
+// the radar area and what it shows, if either has changed
+void Recorder::view(RECT area, const EuroScope::CPosition &sw, const EuroScope::CPosition &ne) {
+	if (!file) return;
+
+	if (
+		!std::memcmp(&area, &last_area, sizeof area) &&
+		sw.m_Latitude == last_sw.m_Latitude && sw.m_Longitude == last_sw.m_Longitude &&
+		ne.m_Latitude == last_ne.m_Latitude && ne.m_Longitude == last_ne.m_Longitude
+	) return;
+
+	last_area = area;
+	last_sw = sw;
+	last_ne = ne;
+
+	begin(record::VIEW);
+	scratch.i16((std::int16_t) std::clamp<long>(area.left, INT16_MIN, INT16_MAX));
+	scratch.i16((std::int16_t) std::clamp<long>(area.top, INT16_MIN, INT16_MAX));
+	scratch.i16((std::int16_t) std::clamp<long>(area.right, INT16_MIN, INT16_MAX));
+	scratch.i16((std::int16_t) std::clamp<long>(area.bottom, INT16_MIN, INT16_MAX));
+	scratch.position(sw);
+	scratch.position(ne);
+	end();
+}
+
+void Recorder::timer(int counter) {
+	if (!file) return;
+
+	begin(record::TIMER);
+	scratch.i32(counter);
+	end();
+}
+
+void Recorder::function(int code, const char *item, EuroScope::CFlightPlan fp) {
+	if (!file) return;
+
+	auto ac = fp.IsValid() ? id(fp.GetCallsign()) : UINT32_MAX;
+
+	begin(record::FUNCTION);
+	scratch.i32(code);
+	scratch.str(item ? item : "");
+	scratch.u32(ac);
+	end();
+}
+
+void Recorder::command(const char *cmd) {
+	if (!file) return;
+
+	begin(record::COMMAND);
+	scratch.str(cmd);
+	end();
+}
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <windows.h>
+
+#include <EuroScopePlugIn.hpp>
+
+namespace EuroScope = EuroScopePlugIn;
+
+// session log format, little-endian throughout: a header of MAGIC, a u32
+// version and the i64 unix time recording started, then records of a u16
+// length of what follows it, a u8 type, a u32 time in ms since the start and
+// the fields below. strings are a u16 length and the bytes; aircraft are
+// the u32 id given by the last callsign record for it; positions are i32
+// latitude and longitude in units of 1e-7 deg. readers skip records they do
+// not know, so types and trailing fields can be added
+//
+// a log opens with a snapshot of the sector, runways, flight plans and
+// positions as the plugin would find them on loading, ended by LIVE
+namespace record {
+
+const char MAGIC[8] = { 'v', 'S', 'M', 'R', '+', 'r', 'e', 'c' };
+const std::uint32_t VERSION = 1;
+
+const double SCALE = 1e7;
+
+enum Type : std::uint8_t {
+	CALLSIGN,      // id, callsign
+	POSITION,      // ac, position, i32 altitude, u16 gs, u16 track in 0.01 deg
+	FLIGHT_PLAN,   // ac, origin, destination, departure and arrival runways,
+	               // u8 engine type, u8 wtc, ground state
+	ASSIGNED,      // ac, u8 data type, ground state, scratch pad, stand annotation
+	DISCONNECT,    // ac
+	METAR,         // aerodrome, metar
+	RUNWAYS,       // u16 count, then each active aerodrome or runway end as
+	               // aerodrome, runway or empty, u8 bit 0 departures and
+	               // bit 1 arrivals
+	REFRESH,       // u8 phase, u32 us taken, u32 tag items got since the last
+	VIEW,          // i16 left, top, right, bottom, position sw, position ne
+	TIMER,         // i32 counter
+	FUNCTION,      // i32 code, item, ac selected or UINT32_MAX
+	COMMAND,       // command
+	ELEMENT,       // u8 sector element type, name, aerodrome, runway names,
+	               // position 0, position 1
+	CONTROLLER,    // position, i32 range
+	LIVE,          //
+	TYPE_COUNT
+};
+
+// encodes records one after another into a buffer
+class Writer {
+private:
+	std::vector<char> buffer;
+	size_t record_at = 0;
+
+	template<typename T>
+	void write(T value) {
+		buffer.insert(buffer.end(), (const char *) &value, (const char *) &value + sizeof value);
+	}
+
+public:
+	const std::vector<char> &data() const { return buffer; }
+	size_t size() const { return buffer.size(); }
+	void clear() { buffer.clear(); }
+
+	void header(std::int64_t start) {
+		buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof MAGIC);
+		write(VERSION);
+		write(start);
+	}
+
+	void begin(Type type, std::uint32_t time) {
+		record_at = buffer.size();
+		write<std::uint16_t>(0);
+		write(type);
+		write(time);
+	}
+
+	// finishes the record; one too long is taken back, and false returned
+	bool end() {
+		size_t length = buffer.size() - record_at - sizeof(std::uint16_t);
+		if (length > UINT16_MAX) {
+			buffer.resize(record_at);
+			return false;
+		}
+
+		set_u16(record_at, (std::uint16_t) length);
+		return true;
+	}
+
+	void u8(std::uint8_t value) { write(value); }
+	void u16(std::uint16_t value) { write(value); }
+	void i16(std::int16_t value) { write(value); }
+	void u32(std::uint32_t value) { write(value); }
+	void i32(std::int32_t value) { write(value); }
+
+	void str(std::string_view value) {
+		value = value.substr(0, UINT16_MAX);
+		u16((std::uint16_t) value.size());
+		buffer.insert(buffer.end(), value.begin(), value.end());
+	}
+
+	void position(const EuroScope::CPosition &posn) {
+		i32((std::int32_t) std::lround(posn.m_Latitude * SCALE));
+		i32((std::int32_t) std::lround(posn.m_Longitude * SCALE));
+	}
+
+	// for filling in a count once what it counts has been written
+	void set_u16(size_t at, std::uint16_t value) {
+		std::memcpy(buffer.data() + at, &value, sizeof value);
+	}
+};
+
+// walks the records of a log held in memory; reading past the end of a
+// record gives zeroes, so older records read as if trailing fields were added
+class Reader {
+private:
+	const char *at = nullptr, *end = nullptr, *field = nullptr, *field_end = nullptr;
+
+	template<typename T>
+	T read() {
+		T value = 0;
+		if (field_end - field < (std::ptrdiff_t) sizeof value) {
+			field = field_end;
+			return value;
+		}
+
+		std::memcpy(&value, field, sizeof value);
+		field += sizeof value;
+		return value;
+	}
+
+public:
+	std::int64_t start = 0;
+	Type type;
+	std::uint32_t time;
+
+	// checks the header; false if this is not a log
+	bool open(const char *data, size_t size) {
+		const size_t header = sizeof MAGIC + sizeof VERSION + sizeof start;
+		if (size < header || std::memcmp(data, MAGIC, sizeof MAGIC)) return false;
+
+		std::memcpy(&start, data + sizeof MAGIC + sizeof VERSION, sizeof start);
+		at = data + header;
+		end = data + size;
+
+		return true;
+	}
+
+	// moves to the next record, if there is a whole one
+	bool next() {
+		std::uint16_t length;
+		if (end - at < (std::ptrdiff_t) sizeof length) return false;
+
+		std::memcpy(&length, at, sizeof length);
+		if (length < 5 || end - at < (std::ptrdiff_t) (sizeof length + length)) return false;
+
+		field = at + sizeof length;
+		field_end = field + length;
+		at = field_end;
+
+		type = (Type) u8();
+		time = u32();
+
+		return true;
+	}
+
+	std::uint8_t u8() { return read<std::uint8_t>(); }
+	std::uint16_t u16() { return read<std::uint16_t>(); }
+	std::int16_t i16() { return read<std::int16_t>(); }
+	std::uint32_t u32() { return read<std::uint32_t>(); }
+	std::int32_t i32() { return read<std::int32_t>(); }
+
+	std::string_view str() {
+		size_t length = std::min<size_t>(u16(), field_end - field);
+		std::string_view value(field, length);
+		field += length;
+		return value;
+	}
+
+	EuroScope::CPosition position() {
+		EuroScope::CPosition posn;
+		posn.m_Latitude = i32() / SCALE;
+		posn.m_Longitude = i32() / SCALE;
+		return posn;
+	}
+};
+
+}
+
+// opt-in log of every callback the plugin gets, for replaying event traffic
+// later. records go into one of two preallocated buffers; when it fills, or
+// each second, the buffers are swapped and a background thread writes the
+// full one out. records are dropped rather than waiting if the writer falls
+// a whole buffer behind
+class Recorder {
+private:
+	static const size_t BUFFER_SIZE = 1 << 20;
+
+	std::FILE *file = nullptr;
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable wake;
+
+	std::unique_ptr<char[]> front, back;
+	size_t front_used = 0, back_used = 0;
+	bool back_full = false, stopping = false;
+
+	record::Writer scratch;
+	std::unordered_map<std::string, std::uint32_t> ids;
+	std::chrono::steady_clock::time_point start_time;
+
+	RECT last_area = {};
+	EuroScope::CPosition last_sw, last_ne;
+
+	void write();
+	bool swap();
+
+	void begin(record::Type);
+	void end();
+
+	std::uint32_t id(const char *);
+
+public:
+	std::uint64_t records = 0, bytes = 0, dropped = 0;
+	std::uint32_t tag_items = 0;
+
+	~Recorder() { stop(); }
+
+	bool active() const { return file; }
+
+	bool start(const std::string &);
+	void stop();
+	void flush();
+
+	void position(EuroScope::CRadarTarget);
+	void flight_plan(EuroScope::CFlightPlan);
+	void assigned(EuroScope::CFlightPlan, int);
+	void disconnect(EuroScope::CFlightPlan);
+	void metar(const char *, const char *);
+	void runways(EuroScope::CPlugIn &);
+	void elements(EuroScope::CPlugIn &);
+	void controller(EuroScope::CController);
+	void live();
+	void refresh(int, std::chrono::steady_clock::duration);
+	void view(RECT, const EuroScope::CPosition &, const EuroScope::CPosition &);
+	void timer(int);
+	void function(int, const char *, EuroScope::CFlightPlan);
+	void command(const char *);
+};